@@ -6,6 +6,7 @@
 #endif
 #include <cstddef>
 #include <map>
+#include <set>
 #include <unordered_set>
 
 namespace infini {
@@ -23,14 +24,23 @@ namespace infini {
     // pointer to the memory actually allocated
     void *ptr;
 
-    // =================================== 作业 ===================================
-    // TODO：可能需要设计一个数据结构来存储free block，以便于管理和合并
-    // HINT: 可以使用一个 map 来存储 free block，key 为 block 的起始/结尾地址，value 为 block 的大小
-    // =================================== 作业 ===================================
+    // size of the memory actually allocated, it only grows
+    size_t capacity;
+
+    // free blocks indexed by head address offset (value is the block size),
+    // adjacent blocks are coalesced on free
     std::map<size_t, size_t> freeBlocks;
-    
+
+    // the same free blocks ordered by (size, address) for best-fit lookup
+    std::set<std::pair<size_t, size_t>> freeBlocksBySize;
+
   public:
-    Allocator(Runtime runtime);
+    // one cache line, also enough for the widest (AVX-512) vector loads
+    static constexpr size_t defaultAlignment = 64;
+
+    // alignment: alignment of every block and of the arena itself, a power
+    // of two no smaller than sizeof(uint64_t)
+    Allocator(Runtime runtime, size_t alignment = defaultAlignment);
 
     virtual ~Allocator();
 
@@ -46,15 +56,44 @@ namespace infini {
     //     size: size of memory block to be freed
     void free(size_t addr, size_t size);
 
-    // function: perform actual memory allocation
+    // function: perform actual memory allocation. The arena is kept across
+    //     reset() and only reallocated when a plan needs more than its
+    //     capacity, which invalidates pointers into the old arena.
     // return: pointer to the head address of the allocated memory
     void *getPtr();
 
+    // function: forget every simulated block so that a new plan can be
+    //     simulated, the actual memory is kept
+    void reset();
+
+    // function: forget every simulated block and free the actual memory,
+    //     e.g. once nothing lives in the arena any more
+    void release();
+
+    size_t getCapacity() const { return capacity; }
+
     void info();
 
-  private:
+    size_t getUsed() const { return used; }
+
+    // return: size of the largest hole below the peak, together with
+    //     getPeak() - getUsed() it tells how fragmented the arena is
+    size_t getLargestFreeBlock() const {
+        return freeBlocksBySize.empty() ? 0 : freeBlocksBySize.rbegin()->first;
+    }
+
+    size_t getAlignment() const { return alignment; }
+
+    // return: size of the arena, i.e. the highest end offset ever allocated
+    size_t getPeak() const { return peak; }
+
     // function: memory alignment, rouned up
     // return: size of the aligned memory block
     size_t getAlignedSize(size_t size);
+
+  private:
+    void insertFreeBlock(size_t addr, size_t size);
+
+    void eraseFreeBlock(size_t addr, size_t size);
   };
 }
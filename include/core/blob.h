@@ -11,15 +11,20 @@ class BlobObj
 {
   Runtime runtime;
   void *ptr;
+  // alignment that `ptr` is guaranteed to have
+  size_t alignment;
 
 public:
-  BlobObj(Runtime runtime, void *ptr) : runtime(runtime), ptr(ptr) {}
+  BlobObj(Runtime runtime, void *ptr, size_t alignment = 1)
+      : runtime(runtime), ptr(ptr), alignment(alignment) {}
   BlobObj(BlobObj &other) = delete;
   BlobObj &operator=(BlobObj const &) = delete;
   ~BlobObj() {};
 
   template <typename T>
   T getPtr() const { return reinterpret_cast<T>(ptr); }
+
+  size_t getAlignment() const { return alignment; }
 };
 
 } // namespace infini
@@ -55,6 +55,11 @@ template <typename T> auto enum_to_underlying(T e) {
     return static_cast<std::underlying_type_t<T>>(e);
 }
 
+// Mix the hash of `value` into `seed`, as boost::hash_combine does
+template <typename T> void hash_combine(size_t &seed, const T &value) {
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
 template <typename T> std::string vecToString(const std::vector<T> &vec) {
     std::stringstream ss;
     ss << "[";
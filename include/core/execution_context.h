@@ -0,0 +1,131 @@
+#pragma once
+#include "core/graph.h"
+
+namespace infini
+{
+    class CompiledPlanObj;
+    using CompiledPlan = Ref<CompiledPlanObj>;
+
+    /**
+     * @brief The part of a graph that every request shares: a snapshot of the
+     * sorted ops, their tensors and kernels, the weights and where each
+     * activation lives in an arena. The snapshot is taken at the current
+     * shapes and later changes to the graph do not reach it. The plan pins
+     * the blocks of its weights in the weight region of the graph, so passes
+     * on the graph that drop a weight leave its data in place until the plan
+     * is gone.
+     *
+     * Each ExecutionContextObj clones the snapshot and binds the activations
+     * of its clone to its own arena, so several contexts can run the same plan
+     * at the same time.
+     */
+    class CompiledPlanObj
+    {
+        friend class ExecutionContextObj;
+
+        Runtime runtime;
+        WeightRegion weights;
+        size_t alignment;
+        // clones of the tensors and ops of the graph, never bound to an arena
+        TensorVec tensors;
+        OpVec ops;
+        // kernel of each op
+        vector<Kernel *> kernels;
+        // inputs and outputs of each op as indices into `tensors`
+        vector<std::pair<vector<size_t>, vector<size_t>>> opTensors;
+        vector<size_t> inputs, outputs;
+        // index into `tensors` by fuid
+        std::unordered_map<UidBaseType, size_t> tensorIndex;
+        // offset in the arena and alignment of the block of each tensor,
+        // {0, 0} for weights
+        vector<std::pair<size_t, size_t>> blocks;
+        size_t arenaSize = 0;
+        size_t workspaceOffset = 0;
+        size_t workspaceSize = 0;
+
+        TensorVec getWeights() const;
+
+    public:
+        /**
+         * @brief Plan the memory of `graph` as GraphObj::dataMalloc does, bind
+         * its weights and take the snapshot.
+         */
+        explicit CompiledPlanObj(const Graph &graph,
+                                 MemoryPlanStrategy strategy =
+                                     MemoryPlanStrategy::Online);
+        ~CompiledPlanObj();
+        CompiledPlanObj(CompiledPlanObj &other) = delete;
+        CompiledPlanObj &operator=(CompiledPlanObj const &) = delete;
+
+        const Runtime &getRuntime() const { return runtime; }
+        size_t getNumOperators() const { return ops.size(); }
+        Kernel *getKernel(size_t op) const { return kernels[op]; }
+        size_t getArenaSize() const { return arenaSize; }
+        size_t getAlignment() const { return alignment; }
+        size_t getWorkspaceOffset() const { return workspaceOffset; }
+        size_t getWorkspaceSize() const { return workspaceSize; }
+
+        /**
+         * @brief The index of the snapshot of `tensor`, a tensor of the
+         * compiled graph, or -1 if it is not in the plan.
+         */
+        int getIndex(const TensorObj &tensor) const
+        {
+            auto it = tensorIndex.find(tensor.getFuid());
+            return it == tensorIndex.end() ? -1 : (int)it->second;
+        }
+    };
+
+    /**
+     * @brief The state of one request on a CompiledPlanObj: an activation
+     * arena and a clone of the ops and tensors of the plan whose activations
+     * are bound to it. Weights share their data with the plan.
+     */
+    class ExecutionContextObj
+    {
+        CompiledPlan plan;
+        void *arena;
+        TensorVec tensors;
+        OpVec ops;
+        TensorVec inputs, outputs;
+
+    public:
+        explicit ExecutionContextObj(CompiledPlan plan);
+        ~ExecutionContextObj();
+        ExecutionContextObj(ExecutionContextObj &other) = delete;
+        ExecutionContextObj &operator=(ExecutionContextObj const &) = delete;
+
+        const CompiledPlan &getPlan() const { return plan; }
+        // the ops to run, in the order and with the kernels of the plan
+        const OpVec &getOperators() const { return ops; }
+        const TensorVec &getInputs() const { return inputs; }
+        const TensorVec &getOutputs() const { return outputs; }
+        void *getWorkspace() const
+        {
+            return static_cast<char *>(arena) + plan->getWorkspaceOffset();
+        }
+
+        /**
+         * @brief The copy in this context of `tensor`, a tensor of the
+         * compiled graph.
+         */
+        const Tensor &getTensor(const TensorObj &tensor) const
+        {
+            int index = plan->getIndex(tensor);
+            IT_ASSERT(index >= 0, "Tensor is not in the plan");
+            return tensors[index];
+        }
+
+        /**
+         * @brief The data of `tensor` in this context, e.g. to write an input
+         * before run or to read an output after it. Weights are shared by
+         * every context.
+         */
+        template <typename T>
+        T getRawDataPtr(const Tensor &tensor) const
+        {
+            return getTensor(*tensor)->getRawDataPtr<T>();
+        }
+    };
+
+} // namespace infini
@@ -1,7 +1,11 @@
 #pragma once
 #include "core/allocator.h"
+#include "core/graph_pass.h"
+#include "core/kernel.h"
+#include "core/memory_planner.h"
 #include "core/operator.h"
 #include "core/tensor.h"
+#include "core/weight_region.h"
 #include <algorithm>
 #include <cstdint>
 
@@ -10,38 +14,108 @@ namespace infini
 
     class GraphObj : public Object
     {
+        friend class CompiledPlanObj;
+
     protected:
         Runtime runtime;
-        TensorVec tensors;
-        OpVec ops;
+        // Removed tensors and ops leave a nullptr slot behind, so removal is
+        // O(1) and indices stay stable while a pass walks the lists. The slots
+        // are dropped by compact() before the lists are read as a whole.
+        mutable TensorVec tensors;
+        mutable OpVec ops;
+        // slot of each tensor by fuid and of each op by guid
+        mutable std::unordered_map<UidBaseType, size_t> tensorIndex;
+        mutable std::unordered_map<UidBaseType, size_t> opIndex;
+        mutable size_t removedTensors = 0;
+        mutable size_t removedOps = 0;
+        // the boundary set by setInputs / setOutputs, inferred if unset
+        optional<TensorVec> declaredInputs, declaredOutputs;
+        // activation arena, re-planned by dataMalloc
         Allocator allocator;
+        // constant tensors, placed once and possibly shared with other graphs
+        WeightRegion weights;
+        // arena layouts planned by dataMalloc, keyed by the signature of the
+        // graph input shapes and the planning strategy
+        std::unordered_map<string, ArenaLayout> memoryPlans;
+        // shape and symbols of each tensor without a producer at the last
+        // shape_infer, empty until the next one after the graph changed
+        std::unordered_map<UidBaseType, std::pair<Shape, vector<string>>>
+            inferredShapes;
+        // sizes each symbolic dim is padded up to, ascending
+        std::unordered_map<string, vector<int>> shapeBuckets;
+        // key of the layout bound by the last dataMalloc
+        string currentPlan;
+        // kernel scratch memory of the current layout inside the arena
+        void *workspace = nullptr;
+        size_t workspaceSize = 0;
 
     public:
-        explicit GraphObj(Runtime runtime)
-            : runtime(runtime), allocator(runtime), sorted(false){};
+        /**
+         * @param alignment Alignment of every tensor buffer in the arena.
+         */
+        explicit GraphObj(Runtime runtime,
+                          size_t alignment = Allocator::defaultAlignment)
+            : runtime(runtime), allocator(runtime, alignment),
+              weights(make_ref<WeightRegionObj>(runtime, alignment)),
+              sorted(true)
+        {
+            weights->attachGraph();
+        }
+        ~GraphObj() { weights->detachGraph(); }
+        GraphObj(const GraphObj &) = delete;
+        GraphObj &operator=(const GraphObj &) = delete;
         string toString() const override;
         Runtime getRuntime() const { return runtime; }
+        size_t getAlignment() const { return allocator.getAlignment(); }
+        WeightRegion getWeightRegion() const { return weights; }
+        // whether another graph, e.g. one given it by setWeightRegion, binds
+        // its weights to the region as well. Compiled plans pin the blocks
+        // they read instead.
+        bool sharesWeightRegion() const { return weights->getNumGraphs() > 1; }
+
+        /**
+         * @brief Scratch memory reserved for the kernels by dataMalloc, the
+         * largest Kernel::getWorkspaceSize() of all ops.
+         */
+        void *getWorkspace() const { return workspace; }
+        size_t getWorkspaceSize() const { return workspaceSize; }
+
+        /**
+         * @brief Bind the weights of this graph into `region` from the next
+         * dataMalloc on, e.g. the region of another graph built from clones of
+         * the same weights.
+         */
+        void setWeightRegion(const WeightRegion &region)
+        {
+            IT_ASSERT(region->getAlignment() >= getAlignment());
+            weights->detachGraph();
+            weights = region;
+            weights->attachGraph();
+        }
 
         Tensor addTensor(Shape dim, DataType dtype = DataType::Float32);
         Tensor addTensor(const Tensor &tensor);
         TensorVec addTensor(const TensorVec &tensors);
-        void removeOperator(Operator op)
+        void removeOperator(Operator op);
+        // also drops `tensor` from the declared inputs and outputs
+        void removeTensor(Tensor tensor);
+
+        const TensorVec &getTensors() const
         {
-            auto it = std::find(ops.begin(), ops.end(), op);
-            if (it != ops.end())
-                ops.erase(it);
+            compact();
+            return tensors;
         }
-
-        void removeTensor(Tensor tensor)
+        const OpVec &getOperators() const
         {
-            auto it = std::find(tensors.begin(), tensors.end(), tensor);
-            if (it != tensors.end())
-                tensors.erase(it);
+            compact();
+            return ops;
         }
-
-        const TensorVec &getTensors() const { return tensors; }
-        const OpVec &getOperators() const { return ops; }
+        /**
+         * @brief Find a tensor by fuid or an op by guid, nullptr if it is not
+         * in the graph.
+         */
         Tensor getTensor(int) const;
+        Operator getOperator(UidBaseType guid) const;
 
         /**
          * @brief Sort the nodes in topological order.
@@ -51,11 +125,92 @@ namespace infini
          */
         bool topo_sort();
 
-        void optimize();
+        /**
+         * @brief Run the registered passes up to `options.level` in order,
+         * round after round, until a round rewrites nothing or
+         * `options.maxIterations` is reached.
+         * @return Runs, rewrites and time of every pass that was enabled.
+         */
+        vector<PassStats> optimize(const OptimizeOptions &options = {});
 
-        void shape_infer();
+        /**
+         * @brief Make `op` read `to` wherever it reads `from`, updating the
+         * links of both tensors and of the producers.
+         */
+        void replaceInput(const Operator &op, const Tensor &from,
+                          const Tensor &to);
 
-        void dataMalloc();
+        /**
+         * @brief Make every consumer of `from` read `to` instead.
+         */
+        void replaceAllUses(const Tensor &from, const Tensor &to);
+
+        /**
+         * @brief Disconnect `op` from its inputs and remove it together with
+         * its outputs, which must have no consumer left.
+         */
+        void eraseOperator(const Operator &op);
+
+        /**
+         * @brief Remove `op` but keep its outputs in the graph without a
+         * source, e.g. once they hold the data `op` would compute.
+         */
+        void detachOperator(const Operator &op);
+
+        /**
+         * @brief Replace the ops of `group` with `replacement`, which reads
+         * tensors produced outside of the group and writes the outputs of the
+         * group that are still read outside of it. The other outputs of the
+         * group are removed.
+         */
+        void replaceSubgraph(const OpVec &group, const Operator &replacement);
+
+        /**
+         * @brief Infer the shapes of the op outputs. Only the ops downstream
+         * of a graph input whose shape changed since the last call run
+         * inferShape, and the propagation stops at outputs whose shape stays
+         * the same; the first call after the graph changed infers every op.
+         * @return The number of ops inferred.
+         */
+        size_t shape_infer();
+
+        /**
+         * @brief Bind the weights to the weight region, then plan the memory
+         * of the other tensors by their lifetimes in the sorted op list and
+         * bind each of them to its block in the activation arena.
+         * Plans are cached by the shapes of the graph inputs, so switching
+         * back to known shapes after shape_infer() only rebinds the tensors.
+         * Symbolic dims with buckets are padded up to their bucket first, so
+         * every size of a bucket shares one plan.
+         * The arena is shared by all plans and grows when a plan needs more.
+         */
+        void dataMalloc(MemoryPlanStrategy strategy = MemoryPlanStrategy::Online);
+
+        /**
+         * @brief Set the sizes, ascending, that the symbolic dim `symbol`
+         * (see TensorObj::setSymbolicDim) is padded up to when dataMalloc
+         * plans the memory. A size above the last bucket is an error.
+         */
+        void setShapeBuckets(const string &symbol, vector<int> buckets);
+
+        /**
+         * @brief The shape of the graph input `tensor` with its symbolic dims
+         * padded up to their buckets.
+         */
+        Shape getPaddedShape(const Tensor &tensor) const;
+
+        /**
+         * @brief Bind the weights to the weight region, so their data can be
+         * loaded before optimize() folds the ops that only read constants.
+         * dataMalloc() does it as well.
+         */
+        void bindWeights();
+
+        /**
+         * @brief Memory timeline of the layout bound by the last dataMalloc:
+         * where each tensor lives and when, and the arena usage of every step.
+         */
+        const MemoryReport &getMemoryReport() const;
 
         /**
          * @brief Add an operator and create its outputs. Output tensor arguments
@@ -81,10 +236,20 @@ namespace infini
         }
 
         /**
-         * @brief Gets input tensors of this graph.
+         * @brief Add an operator built by OperatorObj::clone, whose tensors
+         * are already in the graph.
+         */
+        void addOperator(const Operator &op) { addOperatorAndConnect(op); }
+
+        /**
+         * @brief Gets input tensors of this graph: the declared ones, or the
+         * tensors without a producer.
          */
         inline TensorVec getInputs() const
         {
+            if (declaredInputs)
+                return *declaredInputs;
+            compact();
             TensorVec ret;
             for (const auto &t : tensors)
                 if (!t->getSource())
@@ -93,10 +258,14 @@ namespace infini
         }
 
         /**
-         * @brief Gets output tensors of this graph.
+         * @brief Gets output tensors of this graph: the declared ones, or the
+         * tensors without a consumer.
          */
         inline TensorVec getOutputs() const
         {
+            if (declaredOutputs)
+                return *declaredOutputs;
+            compact();
             TensorVec ret;
             for (const auto &t : tensors)
                 if (t->getTargets().empty())
@@ -104,16 +273,118 @@ namespace infini
             return ret;
         }
 
+        /**
+         * @brief Declare the boundary of the graph. Declared outputs stay
+         * valid after run() even if other ops read them, and only the ops
+         * they depend on survive the dead-code-elimination pass.
+         */
+        void setInputs(const TensorVec &inputs);
+        void setOutputs(const TensorVec &outputs);
+
+        bool isInput(const Tensor &tensor) const;
+        bool isOutput(const Tensor &tensor) const;
+        // whether setInputs / setOutputs fixed the boundary, else it is
+        // inferred from the ops
+        bool hasDeclaredInputs() const { return declaredInputs.has_value(); }
+        bool hasDeclaredOutputs() const { return declaredOutputs.has_value(); }
+        /**
+         * @brief Whether nothing reads `tensor` and it is not a declared
+         * output, so a pass may drop it with its producer.
+         */
+        bool isUnused(const Tensor &tensor) const;
+
         bool checkValid() const;
 
     private:
+        /**
+         * @brief Drop the slots of removed tensors and ops and reindex the
+         * rest, keeping their order.
+         */
+        void compact() const;
+
+        bool contains(const Tensor &tensor) const;
+        bool contains(const Operator &op) const;
+
+        /**
+         * @brief Link `op` to the producers of its inputs and to the
+         * consumers of its outputs, in both directions.
+         */
+        void connect(const Operator &op);
+
+        /**
+         * @brief Drop every link between `op` and its inputs and neighbours.
+         */
+        void disconnect(const Operator &op);
+
+        /**
+         * @brief Rebuild the predecessor links of `op` from its inputs.
+         */
+        void relink(const Operator &op);
+
+        /**
+         * @brief Drop the state derived from the structure of the graph: the
+         * cached memory plans and the shapes shape_infer() last saw.
+         */
+        void invalidate();
+
         /**
          * @brief Add reverse connections and Op relationship in ctor.
          */
         void addOperatorAndConnect(const Operator &op);
 
         /**
-         * @brief If the nodes is sorted in topological order.
+         * @brief Find an input of `op` whose block `output` can take over: the
+         * kernel is in-place safe, the input has no other consumer and the same
+         * shape, symbols and data type as the output. Returns nullptr if there
+         * is none.
+         */
+        Tensor getInPlaceInput(const Operator &op, const Tensor &output) const;
+
+        /**
+         * @brief Find the concat whose output `tensor` can be written into,
+         * so the concat copies nothing: the concat is its only consumer and
+         * slices along the concat dim are contiguous, i.e. every dim before
+         * it is 1. Returns the concat output and sets `offset` to the byte
+         * offset of the slice, or nullptr.
+         */
+        Tensor getConcatOutput(const Tensor &tensor, size_t &offset) const;
+
+        /**
+         * @brief Plan the arena by the tensor lifetimes in the sorted op list.
+         */
+        ArenaLayout planMemory(MemoryPlanStrategy strategy);
+
+        /**
+         * @brief Sort the ops, bind the weights and find the cached layout of
+         * the current input shapes, planning it first if there is none.
+         * @return The signature of the layout and the layout.
+         */
+        const std::pair<const string, ArenaLayout> &
+        getPlan(MemoryPlanStrategy strategy);
+
+        /**
+         * @brief Offset in the arena and alignment of the block of each
+         * tensor under `layout` at the current shapes, {0, 0} for weights.
+         */
+        vector<std::pair<size_t, size_t>>
+        getBlocks(const ArenaLayout &layout) const;
+
+        /**
+         * @brief The kernel that runs `op` on this graph's runtime, or nullptr
+         * if none is registered.
+         */
+        Kernel *findKernel(const Operator &op) const;
+
+        /**
+         * @brief Key of memoryPlans: the strategy and the shapes and data types
+         * of the tensors without a source.
+         */
+        string getPlanSignature(MemoryPlanStrategy strategy) const;
+
+        /**
+         * @brief If the nodes is sorted in topological order. Appending an op
+         * whose outputs have no consumer yet and removing ops keep the order,
+         * so only out-of-order rewrites have to sort again.
          */
         bool sorted;
     };
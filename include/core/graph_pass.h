@@ -0,0 +1,94 @@
+#pragma once
+#include "core/common.h"
+#include <algorithm>
+
+namespace infini
+{
+
+    class GraphObj;
+
+    /**
+     * @brief A rewrite of the graph run by GraphObj::optimize. Passes only
+     * touch the graph through its public rewrite helpers, e.g.
+     * GraphObj::replaceAllUses and GraphObj::eraseOperator, which keep the
+     * links and the topological order valid.
+     */
+    class GraphPass
+    {
+    public:
+        GraphPass() {}
+        virtual ~GraphPass() {}
+
+        /**
+         * @brief Rewrite the graph once.
+         * @return The number of rewrites, 0 if the graph is unchanged.
+         */
+        virtual size_t run(GraphObj &graph) const = 0;
+    };
+
+    struct OptimizeOptions
+    {
+        // run the passes whose level is at most this, 0 disables optimize
+        int level = 2;
+        // rounds of all passes before giving up on reaching a fixpoint
+        size_t maxIterations = 16;
+    };
+
+    struct PassStats
+    {
+        string name;
+        size_t runs = 0;
+        size_t rewrites = 0;
+        double milliseconds = 0;
+    };
+
+    class PassRegistry
+    {
+    public:
+        struct PassRecord
+        {
+            GraphPass *pass;
+            string name;
+            // passes run by ascending order in every round
+            int order;
+            int level;
+        };
+
+    private:
+        vector<PassRecord> passes;
+
+    public:
+        ~PassRegistry()
+        {
+            for (auto &record : passes)
+                delete record.pass;
+        }
+        static PassRegistry &getInstance()
+        {
+            static PassRegistry instance;
+            return instance;
+        }
+        bool registerPass(GraphPass *pass, string name, int order, int level)
+        {
+            for (auto &record : passes)
+                IT_ASSERT(record.name != name, "Pass already registered");
+            auto it = std::upper_bound(
+                passes.begin(), passes.end(), order,
+                [](int order, const PassRecord &record)
+                { return order < record.order; });
+            passes.insert(it, PassRecord{pass, name, order, level});
+            return true;
+        }
+        const vector<PassRecord> &getPasses() const { return passes; }
+    };
+
+} // namespace infini
+
+// a single declaration, so a use ends with a semicolon like REGISTER_KERNEL
+#define _REGISTER_GRAPH_PASS_1(pass, name, order, level, cnt)               \
+    static const bool _CAT(_register_graph_pass_, cnt) =                    \
+        ::infini::PassRegistry::getInstance().registerPass(                 \
+            new ::infini::pass(), name, order, level)
+
+#define REGISTER_GRAPH_PASS(pass, name, order, level) \
+    _REGISTER_GRAPH_PASS_1(pass, name, order, level, __COUNTER__)
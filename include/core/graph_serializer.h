@@ -0,0 +1,36 @@
+#pragma once
+#include "core/graph.h"
+
+namespace infini
+{
+    /**
+     * @brief Binary file format of a graph: a header, the tensors (shape,
+     * data type, symbolic dims, weight flag), the ops with their attributes,
+     * the declared graph inputs and outputs, then a weight section that
+     * starts on a page boundary of the saving host. Numbers are stored in the
+     * byte order of the host. Loading checks every count, index and enum value against
+     * the file and throws on a truncated or corrupt one.
+     *
+     * Loading maps the file and binds the weights to their bytes in the
+     * mapping, so nothing is parsed or copied for them; pages are read when
+     * a kernel first touches them. Writing a loaded weight only changes the
+     * private copy of its pages.
+     */
+    class GraphSerializer
+    {
+    public:
+        /**
+         * @brief Write `graph` to `path`. Every weight must hold data, e.g.
+         * after GraphObj::bindWeights and loading it.
+         */
+        static void save(const Graph &graph, const string &path);
+
+        /**
+         * @brief Build the graph stored in `path` on `runtime`. Inputs and
+         * outputs that were declared when it was saved are declared again,
+         * the others are inferred from the ops.
+         */
+        static Graph load(const Runtime &runtime, const string &path);
+    };
+
+} // namespace infini
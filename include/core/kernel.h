@@ -21,6 +21,20 @@ namespace infini
          */
         virtual void compute(const Operator &op,
                              const RuntimeObj *context) const = 0;
+
+        /**
+         * @brief Whether the kernel stays correct when its output aliases an
+         * input of the same shape and data type, i.e. every output element is
+         * written only after the input element at the same offset is read.
+         */
+        virtual bool isInPlaceSafe() const { return false; }
+
+        /**
+         * @brief Bytes of scratch memory that compute() takes from
+         * RuntimeObj::getWorkspace(). The graph reserves it in its arena, so
+         * kernels never allocate on the heap while running.
+         */
+        virtual size_t getWorkspaceSize(const Operator &op) const { return 0; }
     };
 
     class KernelRegistry
@@ -59,6 +73,10 @@ namespace infini
                                                "}");
             return std::get<0>(it->second);
         }
+        bool hasKernel(const KernelAttrs &kernelAttrs) const
+        {
+            return kernels.find(kernelAttrs) != kernels.end();
+        }
         const KernelRecord &getKernelItem(const KernelAttrs &kernelAttrs) const
         {
             return kernels.at(kernelAttrs);
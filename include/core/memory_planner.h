@@ -0,0 +1,80 @@
+#pragma once
+#include "core/allocator.h"
+#include "core/memory_report.h"
+
+namespace infini
+{
+    enum class MemoryPlanStrategy
+    {
+        // Replay alloc/free events through the Allocator in execution order.
+        Online,
+        // See every lifetime up front and place buffers largest first, each in
+        // the tightest gap left by the already placed buffers it overlaps.
+        GreedyBySize,
+    };
+
+    /**
+     * @brief Lifetime of one buffer of the memory plan. The buffer is live
+     * from step `begin` (its producer runs) to step `end` (its last consumer
+     * runs), both inclusive. `size` is already aligned.
+     */
+    struct BufferLifetime
+    {
+        size_t size;
+        size_t begin;
+        size_t end;
+    };
+
+    struct MemoryPlan
+    {
+        // head address offset of each buffer, in the order of the lifetimes
+        vector<size_t> offsets;
+        // size of the arena the plan needs
+        size_t peak = 0;
+        // maximum live bytes at any step, no placement can beat it
+        size_t lowerBound = 0;
+    };
+
+    /**
+     * @brief Layout of a graph in its activation arena for one input-shape
+     * signature, built by GraphObj::dataMalloc from a MemoryPlan.
+     */
+    struct ArenaLayout
+    {
+        // offset of the block of each tensor, in the order of the tensors of
+        // the graph
+        vector<size_t> offsets;
+        // whether the tensor is written into a slice of a concat output; the
+        // slice offset depends on the current shapes, see
+        // GraphObj::getConcatOutput
+        vector<bool> slices;
+        // scratch memory shared by the kernels, see Kernel::getWorkspaceSize
+        size_t workspaceOffset = 0;
+        size_t workspaceSize = 0;
+        MemoryReport report;
+    };
+
+    class MemoryPlanner
+    {
+    public:
+        /**
+         * @brief Assign an offset to every buffer. On return the arena of
+         * `allocator` covers the planned peak, so getPtr() can materialize it.
+         */
+        static MemoryPlan plan(const vector<BufferLifetime> &lifetimes,
+                               MemoryPlanStrategy strategy,
+                               Allocator &allocator);
+
+        static size_t getLowerBound(const vector<BufferLifetime> &lifetimes);
+
+        static const char *toString(MemoryPlanStrategy strategy);
+
+    private:
+        static vector<size_t> planOnline(const vector<BufferLifetime> &lifetimes,
+                                         Allocator &allocator);
+
+        static vector<size_t>
+        planGreedyBySize(const vector<BufferLifetime> &lifetimes, size_t &peak);
+    };
+
+} // namespace infini
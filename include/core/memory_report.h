@@ -0,0 +1,78 @@
+#pragma once
+#include "core/object.h"
+
+namespace infini
+{
+    struct BufferLifetime;
+
+    /**
+     * @brief Placement of one tensor in the activation arena. Steps are
+     * indices in the sorted op list.
+     */
+    struct TensorMemoryRecord
+    {
+        UidBaseType guid;
+        UidBaseType fuid;
+        size_t offset;
+        // aligned size of the block, the byte size for a concat slice
+        size_t size;
+        // step of the producer, 0 for graph inputs
+        size_t firstUse;
+        // step of the last consumer, the last step for graph outputs
+        size_t lastUse;
+        // the tensor reuses the block of an input in place
+        bool inPlace;
+    };
+
+    /**
+     * @brief Arena usage while the op of one step runs.
+     */
+    struct StepMemoryRecord
+    {
+        size_t step;
+        UidBaseType opGuid;
+        string opType;
+        // bytes of the blocks live at this step
+        size_t liveBytes;
+        // end of the highest live block, the arena needed up to this step
+        size_t extentBytes;
+        // share of the extent that is not live, 1 - liveBytes / extentBytes
+        double fragmentation;
+    };
+
+    /**
+     * @brief Memory timeline of one activation arena plan, built by
+     * GraphObj::dataMalloc and exported as JSON or CSV.
+     */
+    class MemoryReport
+    {
+    public:
+        string strategy;
+        size_t peak = 0;
+        size_t lowerBound = 0;
+        // sum of the aligned sizes of all blocks, the arena without reuse
+        size_t naiveBytes = 0;
+        // first step whose extent reaches the peak
+        size_t peakStep = 0;
+        size_t workspaceSize = 0;
+        size_t weightBytes = 0;
+        vector<TensorMemoryRecord> tensors;
+        vector<StepMemoryRecord> steps;
+
+        /**
+         * @brief Fill the live bytes, extent and fragmentation of the first
+         * `nSteps` steps, and the peak step, from the planned buffers.
+         */
+        void computeTimeline(const vector<BufferLifetime> &lifetimes,
+                             const vector<size_t> &offsets, size_t nSteps);
+
+        const StepMemoryRecord &getPeakStep() const;
+
+        string toJson() const;
+        // one row per tensor
+        string tensorsToCsv() const;
+        // one row per step
+        string stepsToCsv() const;
+    };
+
+} // namespace infini
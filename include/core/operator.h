@@ -23,6 +23,15 @@ namespace infini
         OperatorObj(OpType opType, TensorVec inputs, TensorVec outputs);
         virtual optional<vector<Shape>> inferShape(const TensorVec &inputs) = 0;
         virtual vector<DataType> inferDataType(const TensorVec &inputs) const;
+        /**
+         * @brief The symbols of the output dims (see
+         * TensorObj::setSymbolicDim), once the output shapes are inferred.
+         * By default an output shaped like the first input takes its symbols,
+         * and the dims of other outputs get names of their own when any
+         * input is symbolic, as their size may then vary as well.
+         */
+        virtual vector<vector<string>>
+        inferSymbols(const TensorVec &inputs) const;
         /**
          * @brief Constructs outputs (if requried) and check whether the operator is
          * valid.
@@ -35,13 +44,13 @@ namespace infini
     public: // getter and setter
         const TensorVec &getInputs() const { return inputs; }
         const TensorVec &getOutputs() const { return outputs; }
-        Tensor getInputs(size_t i) const { return inputs.at(i); }
-        Tensor getOutput() const
+        const Tensor &getInputs(size_t i) const { return inputs.at(i); }
+        const Tensor &getOutput() const
         {
             IT_ASSERT(outputs.size() == 1, "Unimplemented");
             return outputs[0];
         }
-        Tensor getOutput(size_t i) const
+        const Tensor &getOutput(size_t i) const
         {
             IT_ASSERT(i < outputs.size(), "Index exceeded");
             return outputs.at(i);
@@ -55,6 +64,21 @@ namespace infini
         virtual int numInputs() const = 0;
         virtual int numOutputs() const = 0;
 
+        /**
+         * @brief Hash of the attributes of the operator, e.g. the permutation
+         * of a transpose. Operators of the same type reading the same inputs
+         * with equal attributes compute the same outputs.
+         */
+        virtual size_t hashAttributes() const { return 0; }
+        /**
+         * @brief Whether the attributes equal those of `other`, an operator
+         * of the same type.
+         */
+        virtual bool equalAttributes(const OperatorObj &other) const
+        {
+            return true;
+        }
+
         /**
          * @brief Clone this operator and replace its inputs and outputs.
          *
@@ -68,6 +92,7 @@ namespace infini
     protected:
         optional<vector<Shape>> inferShape();
         vector<DataType> inferDataType() const;
+        vector<vector<string>> inferSymbols() const;
 
     private:
         void addPredecessors(const Operator &op) { predecessors.emplace_back(op); }
@@ -2,6 +2,7 @@
 #include "core/common.h"
 #include "core/op_type.h"
 #include "core/ref.h"
+#include <mutex>
 
 namespace infini
 {
@@ -10,12 +11,14 @@ namespace infini
   class GraphObj;
   class RuntimeObj;
   class BlobObj;
+  class ExecutionContextObj;
 
   using Tensor = Ref<TensorObj>;
   using Operator = Ref<OperatorObj>;
   using Graph = Ref<GraphObj>;
   using Runtime = Ref<RuntimeObj>;
   using Blob = Ref<BlobObj>;
+  using ExecutionContext = Ref<ExecutionContextObj>;
 
   using TensorVec = vector<Tensor>;
   using OpVec = vector<Operator>;
@@ -38,9 +41,26 @@ namespace infini
     virtual ~RuntimeObj() {}
 
     virtual void run(const Graph &graph) const = 0;
-    virtual void *alloc(size_t size) = 0;
+    // function: run the plan of `context` on its arena; contexts of one plan
+    //     can run on different threads at the same time
+    virtual void run(const ExecutionContext &context) const = 0;
+    // function: run one op outside of a graph, e.g. to fold constants, with
+    //     `workspace` as the scratch memory of its kernel
+    virtual void runOp(const Operator &op, void *workspace,
+                       size_t workspaceSize) const = 0;
+    // return: memory of at least `size` bytes whose address is a multiple of
+    // `alignment`, a power of two
+    virtual void *alloc(size_t size, size_t alignment) = 0;
     virtual void dealloc(void *ptr) = 0;
 
+    /**
+     * @brief Scratch memory for the kernel being run by this thread. At least
+     * the size the kernel declared in Kernel::getWorkspaceSize() is available.
+     */
+    void *getWorkspace(size_t size) const;
+
+    Device getDevice() const { return device; }
+
     bool isCpu() const
     {
       return true;
@@ -49,10 +69,45 @@ namespace infini
     virtual string toString() const = 0;
   };
 
+  enum class CpuAllocMode
+  {
+    // aligned_alloc, zero-filled up front like calloc
+    Heap,
+    // anonymous mmap, the kernel maps and zeros each page on first touch
+    Mmap,
+  };
+
+  enum class HugePageMode
+  {
+    None,
+    // madvise(MADV_HUGEPAGE), honored when THP is enabled in "madvise" mode
+    Transparent,
+    // MAP_HUGETLB from the reserved pool, falls back to normal pages when the
+    // pool is empty
+    Explicit,
+  };
+
+  struct CpuAllocConfig
+  {
+    CpuAllocMode mode = CpuAllocMode::Heap;
+    // the options below only apply to CpuAllocMode::Mmap
+    HugePageMode hugePages = HugePageMode::None;
+    // prefault the whole mapping with MAP_POPULATE
+    bool populate = false;
+    // granule of huge page mappings, 0 for the size the host reports
+    size_t hugePageSize = 0;
+  };
+
   class NativeCpuRuntimeObj : public RuntimeObj
   {
+    CpuAllocConfig allocConfig;
+    // sizes of the live mappings, munmap needs them
+    std::unordered_map<void *, size_t> mappings;
+    std::mutex mappingsMutex;
+
   public:
-    NativeCpuRuntimeObj() : RuntimeObj(Device::CPU) {}
+    explicit NativeCpuRuntimeObj(CpuAllocConfig allocConfig = {})
+        : RuntimeObj(Device::CPU), allocConfig(allocConfig) {}
 
     static Ref<NativeCpuRuntimeObj> &getInstance()
     {
@@ -62,8 +117,21 @@ namespace infini
     }
     void dealloc(void *ptr) override;
     void run(const Graph &graph) const override;
-    void *alloc(size_t size) override;
+    void run(const ExecutionContext &context) const override;
+    void runOp(const Operator &op, void *workspace,
+               size_t workspaceSize) const override;
+    void *alloc(size_t size, size_t alignment) override;
     string toString() const override;
+
+    // the mode only affects later allocations, live ones are freed correctly
+    void setAllocConfig(const CpuAllocConfig &config) { allocConfig = config; }
+    const CpuAllocConfig &getAllocConfig() const { return allocConfig; }
+    // the configured huge page size, else the THP size for Transparent and
+    // Hugepagesize of /proc/meminfo for Explicit, 2 MiB if neither is known
+    size_t getHugePageSize() const;
+
+  private:
+    void *mmapAlloc(size_t size, size_t alignment);
   };
 
 } // namespace infini
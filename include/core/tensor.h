@@ -24,9 +24,13 @@ namespace infini
         WRef<OperatorObj> source;
         Blob data;
         Runtime runtime;
+        bool weight = false;
 
     private:
         Shape shape;
+        // name of the symbolic dim each dim takes its size from, empty for
+        // the fixed dims
+        vector<string> symbols;
         size_t _size; // Cache of Π(shape).
         Fuid fuid;    // Cloned tensors share the same id. Tensors constructed from
                       // scratch have a new id.
@@ -39,8 +43,26 @@ namespace infini
         size_t size() const { return _size; }
         size_t getBytes() const { return _size * dtype.getSize(); }
 
-        Shape getDims() const { return shape; }
+        const Shape &getDims() const { return shape; }
         void setShape(Shape shape_);
+        /**
+         * @brief Mark dim `dim` of a graph input as varying between runs, e.g.
+         * the batch size. Inputs sharing a symbol have the same size there,
+         * and the graph plans its memory per bucket of the symbol, see
+         * GraphObj::setShapeBuckets. GraphObj::shape_infer carries the
+         * symbols to the op outputs, see OperatorObj::inferSymbols.
+         */
+        void setSymbolicDim(int dim, const string &name);
+        /**
+         * @brief Set the symbol of every dim, empty names for fixed dims.
+         */
+        void setSymbolicDims(vector<string> names);
+        // one name per dim, or empty if every dim is fixed
+        const vector<string> &getSymbolicDims() const { return symbols; }
+        string getSymbolicDim(size_t dim) const
+        {
+            return dim < symbols.size() ? symbols[dim] : string();
+        }
         size_t getRank() const { return shape.size(); }
         UidBaseType getFuid() const { return fuid; }
 
@@ -48,6 +70,7 @@ namespace infini
             std::function<void(void *, size_t, DataType)> const &generator) const;
 
         void setDataBlob(const Blob &blob);
+        bool hasData() const { return data != nullptr; }
 
         void printData() const;
         bool equalData(const Tensor &rhs, double relativeError = 1e-6) const;
@@ -69,9 +92,38 @@ namespace infini
             return data->getPtr<T>();
         }
 
+        /**
+         * @brief Alignment in bytes that the data pointer is guaranteed to
+         * have, so kernels can pick aligned fast paths.
+         */
+        size_t getAlignment() const
+        {
+            IT_ASSERT(data != nullptr);
+            return data->getAlignment();
+        }
+
+        /**
+         * @brief Clone the tensor without its connections. The clone shares the
+         * FUID and the data blob of this tensor.
+         */
+        Tensor clone() const
+        {
+            auto obj = make_ref<TensorObj>(*this);
+            obj->targets.clear();
+            obj->source.reset();
+            return obj;
+        }
+
         DataType getDType() const { return dtype; }
         Runtime getRuntime() const { return runtime; }
 
+        // Weights (initialized tensors) are constant and live in the weight
+        // region of the graph instead of the planned activation arena.
+        // Whether a tensor is a graph input is up to the graph, see
+        // GraphObj::isInput.
+        bool isWeight() const { return weight; }
+        void setWeight() { weight = true; }
+
         OpVec getTargets() const { return wrefs_to_refs(targets); }
         Operator getSource() const { return source.lock(); }
 
@@ -0,0 +1,94 @@
+#pragma once
+#include "core/allocator.h"
+#include <deque>
+#include <memory>
+
+namespace infini
+{
+    class WeightRegionObj;
+    using WeightRegion = Ref<WeightRegionObj>;
+
+    /**
+     * @brief Persistent memory of the constant tensors (weights) of a model.
+     * Blocks are placed once and never freed, apart from the activation arena
+     * that dataMalloc re-plans. Blocks are keyed by the FUID of the tensor, so
+     * graphs built from clones of the same weights can share one region
+     * instead of holding a copy each.
+     */
+    class WeightRegionObj
+    {
+        Runtime runtime;
+        size_t alignment;
+        // Weights reserved after a chunk is materialized go to a new chunk,
+        // so bound data never moves.
+        std::deque<Allocator> chunks;
+        size_t materializedChunks = 0;
+        // number of weights placed in each chunk
+        vector<size_t> chunkWeights;
+        // chunk and offset of each block
+        std::unordered_map<UidBaseType, std::pair<size_t, size_t>> offsets;
+        // weights whose data lives outside the chunks, e.g. in a mapped
+        // file, with the owners keeping that memory alive
+        std::unordered_map<UidBaseType, Blob> externalBlobs;
+        vector<std::shared_ptr<void>> owners;
+        size_t externalBytes = 0;
+        // graphs binding their weights here, see GraphObj::sharesWeightRegion
+        size_t graphs = 0;
+        // number of compiled plans reading each block, and the bytes of the
+        // pinned blocks released meanwhile, freed once the last pin goes
+        std::unordered_map<UidBaseType, size_t> pins;
+        std::unordered_map<UidBaseType, size_t> pendingReleases;
+
+        void freeBlock(UidBaseType fuid, size_t bytes);
+
+    public:
+        WeightRegionObj(Runtime runtime,
+                        size_t alignment = Allocator::defaultAlignment)
+            : runtime(runtime), alignment(alignment) {}
+
+        /**
+         * @brief Place the weights that have no block yet.
+         */
+        void reserve(const TensorVec &weights);
+
+        /**
+         * @brief Bind the weights to their blocks, materializing the chunks
+         * placed since the last call. The data of the region is kept across
+         * calls.
+         */
+        void bind(const TensorVec &weights);
+
+        /**
+         * @brief Bind `weight` to `ptr`, memory of at least its size that
+         * `owner` keeps alive, without copying it. The region holds `owner`
+         * as long as it lives.
+         */
+        void bindExternal(const Tensor &weight, void *ptr, size_t alignment,
+                          const std::shared_ptr<void> &owner);
+
+        /**
+         * @brief Drop the block of `weight`, which no graph reads any more.
+         * The hole is reused by later weights of the size, and a chunk is
+         * freed once none of its weights is left.
+         */
+        void release(const Tensor &weight);
+
+        /**
+         * @brief Keep the blocks of `weights` bound while a snapshot, e.g. a
+         * CompiledPlanObj, reads them. A block released in the meantime is
+         * freed by the last unpin instead.
+         */
+        void pin(const TensorVec &weights);
+        void unpin(const TensorVec &weights);
+
+        void attachGraph() { ++graphs; }
+        void detachGraph() { --graphs; }
+        size_t getNumGraphs() const { return graphs; }
+
+        bool contains(const Tensor &weight) const;
+        // bytes of the chunks and of the weights bound externally
+        size_t getSize() const;
+        size_t getAlignment() const { return alignment; }
+    };
+
+} // namespace infini
@@ -23,10 +23,16 @@ class ConcatObj : public OperatorObj {
     OP_CLONE(ConcatObj);
 
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    vector<vector<string>>
+    inferSymbols(const TensorVec &inputs) const override;
 
     std::string toString() const override;
     int numInputs() const override { return inputs.size(); }
     int numOutputs() const override { return 1; }
     int getDim() const { return dim; }
+    size_t hashAttributes() const override { return std::hash<int>{}(dim); }
+    bool equalAttributes(const OperatorObj &other) const override {
+        return dim == static_cast<const ConcatObj &>(other).dim;
+    }
 };
 } // namespace infini
@@ -24,6 +24,8 @@ namespace infini
     ElementWiseObj(OpType type, GraphObj *graph, Tensor input0, Tensor input1,
                    Tensor output);
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    vector<vector<string>>
+    inferSymbols(const TensorVec &inputs) const override;
 
     std::string toString() const override;
     int numInputs() const override { return 2; }
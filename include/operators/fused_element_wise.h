@@ -0,0 +1,46 @@
+#pragma once
+#include "core/operator.h"
+
+namespace infini
+{
+  /**
+   * @brief One step of a fused element-wise expression. Values are numbered
+   * with the inputs of the op first, then one value per step in order.
+   */
+  struct FusedElementWiseStep
+  {
+    // Add, Sub, Mul, Div, Relu or Clip
+    OpType type;
+    int lhs;
+    // -1 for unary steps
+    int rhs;
+    // bounds of Clip
+    std::optional<float> min, max;
+  };
+
+  /**
+   * @brief A chain of element-wise operators evaluated per output element in
+   * one loop. Built by the fuse-element-wise pass; the inputs broadcast to
+   * the output shape and the output is the value of the last step.
+   */
+  class FusedElementWiseObj : public OperatorObj
+  {
+  public:
+    FusedElementWiseObj(GraphObj *graph, TensorVec inputs, Tensor output,
+                        vector<FusedElementWiseStep> steps);
+    OP_CLONE(FusedElementWiseObj);
+    optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    vector<vector<string>>
+    inferSymbols(const TensorVec &inputs) const override;
+
+    std::string toString() const override;
+    int numInputs() const override { return inputs.size(); }
+    int numOutputs() const override { return 1; }
+    const vector<FusedElementWiseStep> &getSteps() const { return steps; }
+    size_t hashAttributes() const override;
+    bool equalAttributes(const OperatorObj &other) const override;
+
+  private:
+    vector<FusedElementWiseStep> steps;
+  };
+} // namespace infini
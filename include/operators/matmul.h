@@ -3,6 +3,13 @@
 
 namespace infini
 {
+    enum class ActType
+    {
+        None,
+        Relu,
+        Clip,
+    };
+
     /**
      * @brief Matrix multiplication.
      *
@@ -15,6 +22,12 @@ namespace infini
         // oppsite to the column-major BLAS.
         bool transA, transB;
 
+        // Fused epilogue, applied to each output element in order: the
+        // optional bias (third input, broadcast to the output), then `act`
+        // with `clipMin` / `clipMax` for Clip.
+        ActType act;
+        std::optional<float> clipMin, clipMax;
+
         // Auxiliary attributes which are not a part of operator attributes.
         int m, n, k;
 
@@ -37,13 +50,23 @@ namespace infini
          * the constructor, C should be an empty Ref.
          * @param transA If matrix A should be transposed when computing.
          * @param transB If matrix B should be transposed when computing.
+         * @param bias Added to the product, broadcast to the shape of C, or
+         * an empty Ref.
+         * @param act Activation applied after the bias.
+         * @param clipMin Lower bound of ActType::Clip.
+         * @param clipMax Upper bound of ActType::Clip.
          */
         MatmulObj(GraphObj *graph, Tensor A, Tensor B, Tensor C,
-                  bool transA = false, bool transB = false);
+                  bool transA = false, bool transB = false,
+                  Tensor bias = nullptr, ActType act = ActType::None,
+                  std::optional<float> clipMin = std::nullopt,
+                  std::optional<float> clipMax = std::nullopt);
         OP_CLONE(MatmulObj);
 
         std::string toString() const override;
         optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+        vector<vector<string>>
+        inferSymbols(const TensorVec &inputs) const override;
 
         int numInputs() const override { return inputs.size(); }
         int numOutputs() const override { return 1; }
@@ -52,6 +75,12 @@ namespace infini
         bool getTransB() const { return transB; }
         void setTransA(bool transA) { this->transA = transA; }
         void setTransB(bool transB) { this->transB = transB; }
+        Tensor getBias() const { return inputs.size() > 2 ? inputs[2] : nullptr; }
+        ActType getAct() const { return act; }
+        std::optional<float> getClipMin() const { return clipMin; }
+        std::optional<float> getClipMax() const { return clipMax; }
+        size_t hashAttributes() const override;
+        bool equalAttributes(const OperatorObj &other) const override;
         int getM() const { return m; }
         int getN() const { return n; }
         int getK() const { return k; }
@@ -22,11 +22,24 @@ namespace infini
                  vector<int> permute);
     OP_CLONE(TransposeObj);
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    vector<vector<string>>
+    inferSymbols(const TensorVec &inputs) const override;
 
     std::string toString() const override;
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
-    std::vector<int> getPermute() const { return transposePermute; }
+    const std::vector<int> &getPermute() const { return transposePermute; }
+    // the output shape must stay the same, e.g. when composing transposes
+    void setPermute(vector<int> permute)
+    {
+      IT_ASSERT(permute.size() == transposePermute.size());
+      transposePermute = std::move(permute);
+    }
+    bool isIdentity() const;
+    // only the last two dims trade places, as transA / transB of a matmul
+    bool swapsLastTwoDims() const;
+    size_t hashAttributes() const override;
+    bool equalAttributes(const OperatorObj &other) const override;
 
   private:
     vector<int> transposePermute;
@@ -37,6 +37,8 @@ namespace infini
     std::string toString() const override;
     std::optional<float> getMin() const { return minValue; };
     std::optional<float> getMax() const { return maxValue; };
+    size_t hashAttributes() const override;
+    bool equalAttributes(const OperatorObj &other) const override;
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
 
@@ -84,6 +86,8 @@ namespace infini
     std::string toString() const override;
     CastType getType() const { return castType; }
     DataType getOutputDataType() const;
+    size_t hashAttributes() const override;
+    bool equalAttributes(const OperatorObj &other) const override;
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
 
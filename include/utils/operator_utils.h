@@ -11,6 +11,16 @@ namespace infini {
 
 // Launch a broadcast shape based on the shape of input A and B
 Shape infer_broadcast(const Shape &A, const Shape &B);
+// Launch the symbols of the dims of the broadcast of A and B, given the
+// symbols of their dims (see TensorObj::getSymbolicDims)
+vector<string> infer_broadcast_symbols(const Shape &A,
+                                       const vector<string> &symbolsA,
+                                       const Shape &B,
+                                       const vector<string> &symbolsB);
+// Write the strides of a tensor of `shape` broadcast to `rank` dims into
+// `strides`, 0 for the dims it is broadcast along. Kernels pass a buffer of
+// their workspace, so nothing is allocated per run.
+void get_broadcast_strides(const Shape &shape, size_t rank, size_t *strides);
 // Launch the real axis based on rank and current axis
 int get_real_axis(const int &axis, const int &rank);
 // Locate the index with size from Shape
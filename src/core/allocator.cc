@@ -3,16 +3,20 @@
 
 namespace infini
 {
-    Allocator::Allocator(Runtime runtime) : runtime(runtime)
+    Allocator::Allocator(Runtime runtime, size_t alignment)
+        : runtime(runtime), alignment(alignment)
     {
         used = 0;
         peak = 0;
         ptr = nullptr;
+        capacity = 0;
 
-        // 'alignment' defaults to sizeof(uint64_t), because it is the length of
-        // the longest data type currently supported by the DataType field of
-        // the tensor
-        alignment = sizeof(uint64_t);
+        // sizeof(uint64_t) is the length of the longest data type currently
+        // supported by the DataType field of the tensor
+        IT_ASSERT(alignment >= sizeof(uint64_t) &&
+                      (alignment & (alignment - 1)) == 0,
+                  "Alignment must be a power of two >= 8, got " +
+                      std::to_string(alignment));
     }
 
     Allocator::~Allocator()
@@ -25,86 +29,112 @@ namespace infini
 
     size_t Allocator::alloc(size_t size)
     {
-        IT_ASSERT(this->ptr == nullptr);
         // pad the size to the multiple of alignment
         size = this->getAlignedSize(size);
 
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来分配内存，返回起始地址偏移量
-        // =================================== 作业 ===================================
-        if (freeBlocks.empty())
+        size_t addr;
+        // best fit: the smallest free block that can hold the request
+        auto it = freeBlocksBySize.lower_bound({size, 0});
+        if (it != freeBlocksBySize.end())
         {
-            freeBlocks[0] = 4096; // Initially, all memory is free
+            auto [blockSize, blockAddr] = *it;
+            eraseFreeBlock(blockAddr, blockSize);
+            if (blockSize > size)
+                insertFreeBlock(blockAddr + size, blockSize - size);
+            addr = blockAddr;
         }
-        for(auto it = freeBlocks.begin(); it != freeBlocks.end(); it ++){
-            auto [addr, blockSize] = *it;
-            if(blockSize >= size){ //blockSize 是可用空间
-                if(blockSize > size){
-                    // Split the block if it's larger than requested size
-                    freeBlocks[addr + size] = blockSize - size;
+        else
+        {
+            // nothing fits, grow the arena at the tail. A free block that
+            // ends at the tail is extended instead of being left behind.
+            addr = this->peak;
+            if (!freeBlocks.empty())
+            {
+                auto last = std::prev(freeBlocks.end());
+                if (last->first + last->second == this->peak)
+                {
+                    addr = last->first;
+                    eraseFreeBlock(last->first, last->second);
                 }
-                freeBlocks.erase(it);
-                used += size;
-                peak = std::max(peak, used);
-                return it->first;
             }
+            this->peak = addr + size;
         }
-        
-        return 0;
-
-
-
-        // if (this->freeBlocks.empty())
-        //     this->freeBlocks[0] = 1024;
-        // for (auto it = this->freeBlocks.begin(); it != this->freeBlocks.end(); ++it)
-        // {
-        //     if (it->second >= size)
-        //     {
-        //         if (it->second > size)
-        //             this->freeBlocks[it->first + size] = it->second - size;
-        //         auto ans = it->first;
-        //         this->freeBlocks.erase(it);
-        //         this->used += size;
-        //         this->peak = (this->peak >= this->used) ? this->peak : this->used;
-        //         return ans;
-        //     }
-        // }
+        this->used += size;
+        return addr;
     }
 
     void Allocator::free(size_t addr, size_t size)
     {
-        IT_ASSERT(this->ptr == nullptr);
         size = getAlignedSize(size);
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来回收内存
-        // =================================== 作业 =================================== 
-        freeBlocks[addr] = size;
-        auto it = freeBlocks.find(addr);
-        auto nextIt = std::next(it);
-        if (nextIt != freeBlocks.end() && it->first + it->second == nextIt->first)
+        IT_ASSERT(addr + size <= this->peak);
+
+        // coalesce with the address-adjacent neighbours
+        auto next = freeBlocks.lower_bound(addr);
+        IT_ASSERT(next == freeBlocks.end() || addr + size <= next->first,
+                  "Freeing a block that overlaps a free block");
+        size_t head = addr, tail = addr + size;
+        if (next != freeBlocks.end() && next->first == tail)
         {
-            it->second += nextIt->second;
-            freeBlocks.erase(nextIt);
+            tail += next->second;
+            eraseFreeBlock(next->first, next->second);
         }
-        auto prevIt = std::prev(it);
-        if (it != freeBlocks.begin() && prevIt->first + prevIt->second == it->first)
+        auto prev = freeBlocks.lower_bound(addr);
+        if (prev != freeBlocks.begin())
         {
-            prevIt->second += it->second;
-            freeBlocks.erase(it);
+            --prev;
+            IT_ASSERT(prev->first + prev->second <= addr,
+                      "Freeing a block that overlaps a free block");
+            if (prev->first + prev->second == addr)
+            {
+                head = prev->first;
+                eraseFreeBlock(prev->first, prev->second);
+            }
         }
-        used = used - size;
+        insertFreeBlock(head, tail - head);
+        this->used -= size;
+    }
+
+    void Allocator::insertFreeBlock(size_t addr, size_t size)
+    {
+        freeBlocks.emplace(addr, size);
+        freeBlocksBySize.emplace(size, addr);
+    }
+
+    void Allocator::eraseFreeBlock(size_t addr, size_t size)
+    {
+        freeBlocks.erase(addr);
+        freeBlocksBySize.erase({size, addr});
     }
 
     void *Allocator::getPtr()
     {
-        if (this->ptr == nullptr)
+        if (this->ptr == nullptr || this->capacity < this->peak)
         {
-            this->ptr = runtime->alloc(this->peak);
-            printf("Allocator really alloc: %p %lu bytes\n", this->ptr, peak);
+            if (this->ptr != nullptr)
+                runtime->dealloc(this->ptr);
+            this->ptr = runtime->alloc(this->peak, this->alignment);
+            this->capacity = this->peak;
         }
         return this->ptr;
     }
 
+    void Allocator::reset()
+    {
+        used = 0;
+        peak = 0;
+        freeBlocks.clear();
+        freeBlocksBySize.clear();
+    }
+
+    void Allocator::release()
+    {
+        reset();
+        if (this->ptr != nullptr)
+            runtime->dealloc(this->ptr);
+        this->ptr = nullptr;
+        this->capacity = 0;
+    }
+
     size_t Allocator::getAlignedSize(size_t size)
     {
         return ((size - 1) / this->alignment + 1) * this->alignment;
@@ -113,6 +143,10 @@ namespace infini
     void Allocator::info()
     {
         std::cout << "Used memory: " << this->used
-                  << ", peak memory: " << this->peak << std::endl;
+                  << ", peak memory: " << this->peak
+                  << ", capacity: " << this->capacity
+                  << ", free blocks: " << freeBlocks.size()
+                  << ", largest free block: " << getLargestFreeBlock()
+                  << std::endl;
     }
 }
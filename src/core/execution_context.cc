@@ -0,0 +1,101 @@
+#include "core/execution_context.h"
+#include "core/blob.h"
+#include "core/runtime.h"
+
+namespace infini
+{
+    CompiledPlanObj::CompiledPlanObj(const Graph &graph,
+                                     MemoryPlanStrategy strategy)
+        : runtime(graph->getRuntime()), weights(graph->getWeightRegion()),
+          alignment(graph->getAlignment())
+    {
+        const auto &layout = graph->getPlan(strategy).second;
+        blocks = graph->getBlocks(layout);
+        for (auto &tensor : graph->getTensors())
+        {
+            tensorIndex.emplace(tensor->getFuid(), tensors.size());
+            auto &clone = tensors.emplace_back(tensor->clone());
+            if (!clone->isWeight())
+                clone->setDataBlob(nullptr);
+        }
+        auto indicesOf = [&](const TensorVec &list)
+        {
+            vector<size_t> indices;
+            for (auto &tensor : list)
+                indices.emplace_back(tensorIndex.at(tensor->getFuid()));
+            return indices;
+        };
+        auto tensorsAt = [&](const vector<size_t> &indices)
+        {
+            TensorVec list;
+            for (auto index : indices)
+                list.emplace_back(tensors[index]);
+            return list;
+        };
+        for (auto &op : graph->getOperators())
+        {
+            auto kernel = graph->findKernel(op);
+            IT_ASSERT(kernel, "No kernel for " + op->getOpType().toString());
+            kernels.emplace_back(kernel);
+            auto &[opInputs, opOutputs] = opTensors.emplace_back(
+                indicesOf(op->getInputs()), indicesOf(op->getOutputs()));
+            ops.emplace_back(
+                op->clone(tensorsAt(opInputs), tensorsAt(opOutputs)));
+        }
+        weights->pin(getWeights());
+        inputs = indicesOf(graph->getInputs());
+        outputs = indicesOf(graph->getOutputs());
+        arenaSize = layout.report.peak;
+        workspaceOffset = layout.workspaceOffset;
+        workspaceSize = layout.workspaceSize;
+    }
+
+    CompiledPlanObj::~CompiledPlanObj() { weights->unpin(getWeights()); }
+
+    TensorVec CompiledPlanObj::getWeights() const
+    {
+        TensorVec list;
+        for (auto &tensor : tensors)
+            if (tensor->isWeight())
+                list.emplace_back(tensor);
+        return list;
+    }
+
+    ExecutionContextObj::ExecutionContextObj(CompiledPlan plan)
+        : plan(std::move(plan))
+    {
+        const auto &p = *this->plan;
+        arena = p.runtime->alloc(p.arenaSize, p.alignment);
+        char *basePtr = static_cast<char *>(arena);
+        for (size_t i = 0; i < p.tensors.size(); ++i)
+        {
+            auto tensor = tensors.emplace_back(p.tensors[i]->clone());
+            if (tensor->isWeight())
+                continue;
+            auto [offset, alignment] = p.blocks[i];
+            tensor->setDataBlob(
+                make_ref<BlobObj>(p.runtime, basePtr + offset, alignment));
+        }
+        auto tensorsAt = [&](const vector<size_t> &indices)
+        {
+            TensorVec list;
+            for (auto index : indices)
+                list.emplace_back(tensors[index]);
+            return list;
+        };
+        for (size_t i = 0; i < p.ops.size(); ++i)
+        {
+            const auto &[opInputs, opOutputs] = p.opTensors[i];
+            ops.emplace_back(
+                p.ops[i]->clone(tensorsAt(opInputs), tensorsAt(opOutputs)));
+        }
+        inputs = tensorsAt(p.inputs);
+        outputs = tensorsAt(p.outputs);
+    }
+
+    ExecutionContextObj::~ExecutionContextObj()
+    {
+        plan->runtime->dealloc(arena);
+    }
+
+} // namespace infini
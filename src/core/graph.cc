@@ -1,16 +1,32 @@
 #include "core/graph.h"
+#include "operators/concat.h"
 #include <algorithm>
+#include <chrono>
 #include <numeric>
 #include <queue>
-#include "operators/matmul.h"
-#include "operators/transpose.h"
 namespace infini
 {
 
     void GraphObj::addOperatorAndConnect(const Operator &op)
     {
-        sorted = false;
+        invalidate();
+        opIndex[op->getGuid()] = ops.size();
         ops.push_back(op);
+        connect(op);
+        // appended after all its producers, the order stays valid unless some
+        // op already in the list consumes its outputs
+        if (!op->getSuccessors().empty())
+            sorted = false;
+    }
+
+    void GraphObj::invalidate()
+    {
+        memoryPlans.clear();
+        inferredShapes.clear();
+    }
+
+    void GraphObj::connect(const Operator &op)
+    {
         for (auto &input : op->getInputs())
         {
             if (input)
@@ -37,8 +53,23 @@ namespace infini
         }
     }
 
+    void GraphObj::disconnect(const Operator &op)
+    {
+        for (auto &input : op->getInputs())
+            input->removeTarget(op);
+        for (auto &pred : op->predecessors)
+            if (auto p = pred.lock())
+                p->removeSuccessors(op);
+        for (auto &succ : op->successors)
+            if (auto s = succ.lock())
+                s->removePredecessors(op);
+        op->predecessors.clear();
+        op->successors.clear();
+    }
+
     string GraphObj::toString() const
     {
+        compact();
         std::ostringstream oss;
         oss << "Graph Tensors:\n";
         for (const auto &tensor : tensors)
@@ -62,294 +93,759 @@ namespace infini
 
     bool GraphObj::topo_sort()
     {
+        compact();
         if (this->sorted)
         {
             return true;
         }
+        // Kahn's algorithm over the successor links, O((V + E) log V). An op
+        // that reads the same tensor twice has its producer listed twice, so
+        // the edges are counted with multiplicity on both sides.
+        std::unordered_map<OperatorObj *, size_t> indegree, position;
+        indegree.reserve(ops.size());
+        position.reserve(ops.size());
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            indegree.emplace(ops[i].get(), 0);
+            position.emplace(ops[i].get(), i);
+        }
+        for (auto const &op : ops)
+            for (auto const &succ : op->getSuccessors())
+                if (auto it = indegree.find(succ.get()); it != indegree.end())
+                    ++it->second;
+
+        // always take the ready op that comes first in the current order, so
+        // an already sorted list is kept as is
+        std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>>
+            ready;
+        for (size_t i = 0; i < ops.size(); ++i)
+            if (indegree[ops[i].get()] == 0)
+                ready.push(i);
         std::vector<Operator> sorted;
-        std::unordered_set<OperatorObj *> flags;
         sorted.reserve(ops.size());
-        flags.reserve(ops.size());
-        while (sorted.size() < ops.size())
+        while (!ready.empty())
+        {
+            sorted.emplace_back(ops[ready.top()]);
+            ready.pop();
+            for (auto const &succ : sorted.back()->getSuccessors())
+                if (auto it = indegree.find(succ.get());
+                    it != indegree.end() && --it->second == 0)
+                    ready.push(position.at(succ.get()));
+        }
+        if (sorted.size() < ops.size())
         {
-            // Any node is move to sorted in this loop.
-            auto modified = false;
-            for (auto const &op : ops)
+            // there is a ring in the graph
+            return false;
+        }
+        this->ops = std::move(sorted);
+        for (size_t i = 0; i < ops.size(); ++i)
+            opIndex[ops[i]->getGuid()] = i;
+        return this->sorted = true;
+    }
+
+    vector<PassStats> GraphObj::optimize(const OptimizeOptions &options)
+    {
+        vector<const PassRegistry::PassRecord *> passes;
+        vector<PassStats> stats;
+        for (auto &record : PassRegistry::getInstance().getPasses())
+            if (record.level <= options.level)
             {
-                if (auto const &inputs = op->getInputs();
-                    flags.find(op.get()) == flags.end() &&
-                    std::all_of(inputs.begin(), inputs.end(),
-                                [&flags](auto const &input)
-                                {
-                                    auto ptr = input->getSource().get();
-                                    return !ptr || flags.find(ptr) != flags.end();
-                                }))
-                {
-                    modified = true;
-                    sorted.emplace_back(op);
-                    flags.insert(op.get());
-                }
+                passes.emplace_back(&record);
+                stats.push_back({record.name});
             }
-            if (!modified)
+        // a rewrite may expose new opportunities to any pass, so run them all
+        // again until the graph stops changing
+        for (size_t iter = 0; iter < options.maxIterations; ++iter)
+        {
+            size_t rewrites = 0;
+            for (size_t i = 0; i < passes.size(); ++i)
             {
-                return false;
+                auto begin = std::chrono::steady_clock::now();
+                auto n = passes[i]->pass->run(*this);
+                compact();
+                auto end = std::chrono::steady_clock::now();
+                stats[i].runs += 1;
+                stats[i].rewrites += n;
+                stats[i].milliseconds +=
+                    std::chrono::duration<double, std::milli>(end - begin)
+                        .count();
+                rewrites += n;
             }
+            if (rewrites == 0)
+                break;
         }
-        this->ops = std::move(sorted);
-        return this->sorted = true;
+        return stats;
     }
 
-    void GraphObj::optimize()
+    void GraphObj::replaceInput(const Operator &op, const Tensor &from,
+                                const Tensor &to)
     {
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来实现指定的图优化规则
-        // 图优化规则如下：
-        // 1. 去除冗余的算子（例如，两个相邻的算子都是 transpose 算子，且做的是相反的操作，可以将其全部删除）
-        // 2. 合并算子（例如，矩阵乘算子中含有属性transA、transB，如果其输入存在transpose，且对最后两个维度做交换，就可以将transpose融入到矩阵乘算子的属性中去）
-        // =================================== 作业 ===================================
+        IT_ASSERT(from != to);
+        invalidate();
+        from->removeTarget(op);
+        for (auto &input : op->getInputs())
+            if (input == from)
+                to->addTarget(op);
+        op->replaceInput(from, to);
+        relink(op);
+        // the new producer may come after the consumer in the sorted list
+        if (auto source = to->getSource(); source && sorted)
+            if (opIndex.at(source->getGuid()) > opIndex.at(op->getGuid()))
+                sorted = false;
+    }
 
-        // rule1: 删除无用的transpose算子
-        for (size_t i = 0; i < ops.size(); ++i)
+    void GraphObj::replaceAllUses(const Tensor &from, const Tensor &to)
+    {
+        for (auto &op : from->getTargets())
         {
-            Operator op = ops[i];
-            if (op->getOpType() == OpType::Transpose)
-            {
-                Tensor tensor = op->getOutput();
-                if (!tensor)
-                    continue;
-                auto targets = tensor->getTargets();
-                if (targets.empty())
-                    continue;
-                Operator op_next = targets[0];
-                if (op_next->getOpType() == OpType::Transpose)
+            // an op reading `from` twice is listed twice
+            auto inputs = op->getInputs();
+            if (std::find(inputs.begin(), inputs.end(), from) != inputs.end())
+                replaceInput(op, from, to);
+        }
+    }
+
+    void GraphObj::eraseOperator(const Operator &op)
+    {
+        disconnect(op);
+        for (auto &output : op->getOutputs())
+        {
+            IT_ASSERT(output->getTargets().empty(),
+                      "Erasing an op whose outputs are still used");
+            removeTensor(output);
+        }
+        removeOperator(op);
+    }
+
+    void GraphObj::detachOperator(const Operator &op)
+    {
+        disconnect(op);
+        for (auto &output : op->getOutputs())
+            output->source.reset();
+        removeOperator(op);
+    }
+
+    void GraphObj::replaceSubgraph(const OpVec &group, const Operator &replacement)
+    {
+        IT_ASSERT(!group.empty());
+        // the replacement takes the slot of the last op of the group
+        size_t slot = 0;
+        for (auto &op : group)
+            slot = std::max(slot, opIndex.at(op->getGuid()));
+        for (auto &op : group)
+            disconnect(op);
+        const auto &kept = replacement->getOutputs();
+        for (auto &op : group)
+        {
+            for (auto &output : op->getOutputs())
+                if (std::find(kept.begin(), kept.end(), output) == kept.end())
                 {
-                    TransposeObj *op1 = as<TransposeObj>(op).get();
-                    TransposeObj *op2 = as<TransposeObj>(op_next).get();
-                    auto op1_permute = op1->getPermute();
-                    auto op2_permute = op2->getPermute();
-                    if (op1_permute.size() != op2_permute.size())
-                        continue;
-                    bool flag = true;
-                    for (int j = 0; j < (int)op1_permute.size(); j++)
-                    {
-                        if (op1_permute[op2_permute[j]] != j)
-                        {
-                            flag = false;
-                            continue;
-                        }
-                    }
-                    if (!flag) //flag为false说明 无法合并
-                        continue;
-                    // 获取第一个转置算子的输入张量（原始输入数据）
-                    Tensor originalInput = op->getInputs()[0];  
+                    IT_ASSERT(output->getTargets().empty(),
+                              "Replacing an op whose outputs are still used");
+                    removeTensor(output);
+                }
+            removeOperator(op);
+        }
+        ops[slot] = replacement;
+        opIndex[replacement->getGuid()] = slot;
+        --removedOps;
+        connect(replacement);
+        // a kept output of an earlier op of the group may have consumers
+        // between that op and the slot
+        for (auto &succ : replacement->getSuccessors())
+            if (opIndex.at(succ->getGuid()) < slot)
+                sorted = false;
+    }
 
-                    // 获取第一个转置算子的输出张量（第一次转置结果）
-                    Tensor firstTransposeOutput = op->getOutput();  
+    void GraphObj::relink(const Operator &op)
+    {
+        for (auto &pred : op->predecessors)
+            if (auto p = pred.lock())
+                p->removeSuccessors(op);
+        op->predecessors.clear();
+        for (auto &input : op->getInputs())
+            if (auto pred = input->getSource())
+            {
+                pred->addSuccessors(op);
+                op->addPredecessors(pred);
+            }
+    }
 
-                    // 获取第二个转置算子的输出张量（最终转置结果） 
-                    Tensor secondTransposeOutput = op_next->getOutput();
+    Tensor GraphObj::getTensor(int fuid) const
+    {
+        auto it = tensorIndex.find(fuid);
+        return it == tensorIndex.end() ? nullptr : tensors[it->second];
+    }
 
-                    // 获取使用最终结果的消费者算子（如矩阵乘法）
-                    Operator consumerOp = secondTransposeOutput->getTargets()[0];  
+    Operator GraphObj::getOperator(UidBaseType guid) const
+    {
+        auto it = opIndex.find(guid);
+        return it == opIndex.end() ? nullptr : ops[it->second];
+    }
 
-                    // 保留消费者算子的其他输入（如矩阵乘法的右矩阵）
-                    Tensor consumerOtherInput = consumerOp->getInputs()[1];  
+    void GraphObj::removeOperator(Operator op)
+    {
+        auto it = opIndex.find(op->getGuid());
+        if (it == opIndex.end() || ops[it->second] != op)
+            return;
+        invalidate();
+        ops[it->second] = nullptr;
+        opIndex.erase(it);
+        ++removedOps;
+    }
 
-                    // 重定向消费者算子的输入：跳过两个转置，直接使用原始输入
-                    consumerOp->replaceInput(consumerOp->getInputs()[0], originalInput);
+    void GraphObj::removeTensor(Tensor tensor)
+    {
+        auto it = tensorIndex.find(tensor->getFuid());
+        if (it == tensorIndex.end() || tensors[it->second] != tensor)
+            return;
+        invalidate();
+        tensors[it->second] = nullptr;
+        tensorIndex.erase(it);
+        ++removedTensors;
+        // a removed tensor leaves the declared boundary too, e.g. a weight
+        // input that fold-constants folds away
+        for (auto *declared : {&declaredInputs, &declaredOutputs})
+            if (*declared)
+                (*declared)->erase(std::remove((*declared)->begin(),
+                                               (*declared)->end(), tensor),
+                                   (*declared)->end());
+    }
 
-                    // 更新原始输入的连接关系：
-                    originalInput->removeTarget(op);          // 移除对第一个转置的引用
-                    originalInput->addTarget(consumerOp);     // 添加对消费者算子的引用
-                    originalInput->setSource(nullptr);        // 清除可能存在的生产者标记
+    void GraphObj::compact() const
+    {
+        if (removedTensors > 0)
+        {
+            tensors.erase(std::remove(tensors.begin(), tensors.end(), nullptr),
+                          tensors.end());
+            for (size_t i = 0; i < tensors.size(); ++i)
+                tensorIndex[tensors[i]->getFuid()] = i;
+            removedTensors = 0;
+        }
+        if (removedOps > 0)
+        {
+            ops.erase(std::remove(ops.begin(), ops.end(), nullptr), ops.end());
+            for (size_t i = 0; i < ops.size(); ++i)
+                opIndex[ops[i]->getGuid()] = i;
+            removedOps = 0;
+        }
+    }
 
-                    // 清理冗余资源
-                    removeOperator(op);                      // 删除第一个转置算子
-                    removeOperator(op_next);                 // 删除第二个转置算子
-                    removeTensor(firstTransposeOutput);       // 删除中间结果张量
-                    removeTensor(secondTransposeOutput);     // 删除最终结果张量
+    bool GraphObj::contains(const Tensor &tensor) const
+    {
+        auto it = tensorIndex.find(tensor->getFuid());
+        return it != tensorIndex.end() && tensors[it->second] == tensor;
+    }
 
-                    // 更新算子间的拓扑依赖关系
-                    consumerOp->removePredecessors(op_next); // 移除与第二个转置的依赖
+    bool GraphObj::contains(const Operator &op) const
+    {
+        auto it = opIndex.find(op->getGuid());
+        return it != opIndex.end() && ops[it->second] == op;
+    }
 
-                    // 如果原始输入有生产者，建立新的依赖关系
-                    if (originalInput->getSource()) {
-                        consumerOp->addPredecessors(originalInput->getSource());
-                        originalInput->getSource()->addSuccessors(consumerOp);
-                    }
+    size_t GraphObj::shape_infer()
+    {
+        IT_ASSERT(topo_sort() == true);
+        // re-infer only the ops downstream of an input whose shape changed
+        // since the last run, or all of them after the graph changed
+        bool full = inferredShapes.empty();
+        std::set<size_t> dirty;
+        auto markTargets = [&](const Tensor &tensor)
+        {
+            for (auto &target : tensor->getTargets())
+                dirty.insert(opIndex.at(target->getGuid()));
+        };
+        if (full)
+            for (size_t i = 0; i < ops.size(); ++i)
+                dirty.insert(i);
+        else
+            for (auto &tensor : tensors)
+                if (!tensor->getSource())
+                {
+                    auto it = inferredShapes.find(tensor->getFuid());
+                    if (it == inferredShapes.end() ||
+                        it->second.first != tensor->getDims() ||
+                        it->second.second != tensor->getSymbolicDims())
+                        markTargets(tensor);
                 }
+
+        // sorted, so the producers of an op are settled before it is popped
+        size_t inferred = 0;
+        while (!dirty.empty())
+        {
+            auto &op = ops[*dirty.begin()];
+            dirty.erase(dirty.begin());
+            auto ans = op->inferShape();
+            IT_ASSERT(ans.has_value());
+            const auto &outputs = op->getOutputs();
+            IT_ASSERT(ans.value().size() == outputs.size());
+            ++inferred;
+            for (size_t i = 0; i < outputs.size(); ++i)
+            {
+                if (ans.value()[i] == outputs[i]->getDims())
+                    continue;
+                outputs[i]->setShape(ans.value()[i]);
+                if (!full)
+                    markTargets(outputs[i]);
+            }
+            // symbols are inferred from the new shapes
+            auto symbols = op->inferSymbols();
+            IT_ASSERT(symbols.size() == outputs.size());
+            for (size_t i = 0; i < outputs.size(); ++i)
+            {
+                // unchanged shapes and symbols stop the propagation; no
+                // names and only empty names both mean fixed dims
+                auto &names = symbols[i];
+                if (std::all_of(names.begin(), names.end(),
+                                [](const string &name) { return name.empty(); }))
+                    names.clear();
+                if (names == outputs[i]->getSymbolicDims())
+                    continue;
+                outputs[i]->setSymbolicDims(names);
+                if (!full)
+                    markTargets(outputs[i]);
             }
         }
-        
-        // 遍历图中的所有算子，寻找可优化的矩阵乘法算子
-        for (size_t opIndex = 0; opIndex < ops.size(); ++opIndex) {
-            Operator currentOp = ops[opIndex];
-            
-            // 只处理矩阵乘法算子
-            if (currentOp->getOpType() == OpType::MatMul) {
-                // 获取矩阵乘法的输入张量列表（左矩阵和右矩阵）
-                TensorVec matmulInputs = currentOp->getInputs();
-                int inputIndex = 0;  // 用于标识当前是左输入(0)还是右输入(1)
-                
-                // 检查每个输入张量
-                for (Tensor inputTensor : matmulInputs) {
-                    inputIndex++;
-                    
-                    // 检查输入张量是否有生产者算子
-                    if (inputTensor->getSource()) {
-                        Operator producerOp = inputTensor->getSource();
-                        
-                        // 如果生产者是转置算子
-                        if (producerOp->getOpType() == OpType::Transpose) {
-                            TransposeObj *transposeOp = as<TransposeObj>(producerOp).get();
-                            Shape transposePerm = transposeOp->getPermute();
-                            bool isLastTwoDimsSwap = true;
-                            
-                            /* 验证转置操作是否只交换最后两个维度：
-                            * 1. 前n-2个维度必须保持原顺序（即perm[j] == j）
-                            * 2. 最后两个维度必须交换（即perm[-2] == rank-1 且 perm[-1] == rank-2）
-                            */
-                            for (int dim = 0; dim < (int)transposePerm.size() - 2; dim++) {
-                                if (transposePerm[dim] != dim) {
-                                    isLastTwoDimsSwap = false;
-                                    break;
-                                }
-                            }
-                            if (transposePerm[transposePerm.size() - 2] != (int)transposePerm.size() - 1 || 
-                                transposePerm[transposePerm.size() - 1] != (int)transposePerm.size() - 2) {
-                                isLastTwoDimsSwap = false;
-                            }
-                            
-                            // 如果不满足条件则跳过优化
-                            if (!isLastTwoDimsSwap) continue;
-                            
-                            // 获取矩阵乘法算子（用于修改转置属性）
-                            MatmulObj *matmulOp = as<MatmulObj>(currentOp).get();
-                            Tensor transposedTensor;
-                            
-                            // 根据输入位置设置对应的转置标志
-                            if (inputIndex == 1) {  // 左输入
-                                matmulOp->setTransA(true);  // 启用左矩阵转置
-                                transposedTensor = matmulOp->getInputs(0);
-                            } else {  // 右输入
-                                matmulOp->setTransB(true);  // 启用右矩阵转置
-                                transposedTensor = matmulOp->getInputs(1);
-                            }
-                            
-                            // 获取转置算子的输入（原始未转置的张量）
-                            Operator transposeOperator = transposedTensor->getSource();
-                            Tensor originalTensor = transposeOperator->getInputs()[0];
-                            
-                            // 重定向矩阵乘法的输入：跳过转置算子，直接使用原始张量
-                            matmulOp->replaceInput(transposedTensor, originalTensor);
-                            
-                            // 更新张量连接关系
-                            originalTensor->removeTarget(transposeOperator);
-                            originalTensor->addTarget(currentOp);
-                            
-                            // 清理资源：删除转置算子和中间张量
-                            removeOperator(transposeOperator);
-                            removeTensor(transposedTensor);
-                            
-                            // 更新拓扑关系：移除转置算子作为前驱
-                            currentOp->removePredecessors(transposeOperator);
-                            
-                            // 如果原始张量有生产者，建立新的依赖关系
-                            if (originalTensor->getSource()) {
-                                currentOp->addPredecessors(originalTensor->getSource());
-                                originalTensor->getSource()->addSuccessors(currentOp);
-                            }
-                        }
-                    }
+
+        inferredShapes.clear();
+        for (auto &tensor : tensors)
+            if (!tensor->getSource())
+                inferredShapes.emplace(
+                    tensor->getFuid(),
+                    std::make_pair(tensor->getDims(), tensor->getSymbolicDims()));
+        return inferred;
+    }
+
+    void GraphObj::dataMalloc(MemoryPlanStrategy strategy)
+    {
+        const auto &[signature, layout] = getPlan(strategy);
+        currentPlan = signature;
+
+        // every cached plan fits in the arena, it only grows
+        char *basePtr = reinterpret_cast<char *>(allocator.getPtr());
+        auto blocks = getBlocks(layout);
+        for (size_t i = 0; i < tensors.size(); ++i)
+            if (!tensors[i]->isWeight())
+                tensors[i]->setDataBlob(make_ref<BlobObj>(
+                    runtime, basePtr + blocks[i].first, blocks[i].second));
+        workspace = basePtr + layout.workspaceOffset;
+        workspaceSize = layout.workspaceSize;
+    }
+
+    const std::pair<const string, ArenaLayout> &
+    GraphObj::getPlan(MemoryPlanStrategy strategy)
+    {
+        // topological sorting first
+        IT_ASSERT(topo_sort() == true);
+
+        bindWeights();
+        // the symbols of the op outputs decide which blocks may be shared
+        shape_infer();
+
+        auto signature = getPlanSignature(strategy);
+        auto cached = memoryPlans.find(signature);
+        if (cached != memoryPlans.end())
+            return *cached;
+        // compile the plan at the shapes padded to their buckets; every
+        // tensor only shrinks with its inputs, so smaller shapes of the
+        // bucket fit in the same blocks
+        bool padded = false;
+        for (auto &tensor : tensors)
+            padded |= !tensor->getSource() &&
+                      getPaddedShape(tensor) != tensor->getDims();
+        if (!padded)
+            return *memoryPlans.emplace(signature, planMemory(strategy)).first;
+
+        // the actual shapes and inference state come back however planning
+        // ends; ops also keep state from inferShape, e.g. the m, n and k of a
+        // matmul, so they are inferred again at the restored shapes
+        struct Restore
+        {
+            decltype(GraphObj::inferredShapes) &state;
+            decltype(GraphObj::inferredShapes) saved;
+            const OpVec &ops;
+            vector<std::tuple<Tensor, Shape, vector<string>>> tensors;
+            ~Restore()
+            {
+                for (auto &[tensor, shape, symbols] : tensors)
+                {
+                    tensor->setShape(shape);
+                    tensor->setSymbolicDims(symbols);
                 }
+                for (auto &op : ops)
+                    op->inferShape();
+                state = std::move(saved);
             }
-}
+        } restore{inferredShapes, inferredShapes, ops, {}};
+        for (auto &tensor : tensors)
+            restore.tensors.emplace_back(tensor, tensor->getDims(),
+                                         tensor->getSymbolicDims());
+        for (auto &tensor : tensors)
+            if (!tensor->getSource())
+                tensor->setShape(getPaddedShape(tensor));
+        shape_infer();
+        cached = memoryPlans.emplace(signature, planMemory(strategy)).first;
+        return *cached;
     }
 
-    Tensor GraphObj::getTensor(int fuid) const
+    vector<std::pair<size_t, size_t>>
+    GraphObj::getBlocks(const ArenaLayout &layout) const
     {
-        for (auto tensor : tensors)
+        vector<std::pair<size_t, size_t>> blocks(tensors.size(), {0, 0});
+        for (size_t i = 0; i < tensors.size(); ++i)
         {
-            if (tensor->getFuid() == fuid)
+            if (tensors[i]->isWeight())
+                continue;
+            // a slice sits in the block of the outermost concat output at the
+            // offset of the current shapes
+            size_t offset = layout.offsets[i], sliceOffset = 0;
+            for (auto tensor = tensors[i];
+                 layout.slices[tensorIndex.at(tensor->getFuid())];)
             {
-                return tensor;
+                tensor = getConcatOutput(tensor, sliceOffset);
+                IT_ASSERT(tensor);
+                offset += sliceOffset;
             }
+            // a slice of a concat output is only as aligned as its offset
+            size_t alignment = allocator.getAlignment();
+            if (offset % alignment != 0)
+                alignment = offset & (~offset + 1);
+            blocks[i] = {offset, alignment};
         }
-        return nullptr;
+        return blocks;
     }
 
-    void GraphObj::shape_infer()
+    void GraphObj::bindWeights()
     {
-        for (auto &op : ops)
+        compact();
+        TensorVec weightTensors;
+        for (auto &tensor : tensors)
+            if (tensor->isWeight())
+                weightTensors.emplace_back(tensor);
+        weights->bind(weightTensors);
+    }
+
+    ArenaLayout GraphObj::planMemory(MemoryPlanStrategy strategy)
+    {
+        // Liveness analysis: an intermediate tensor lives from the step (index
+        // in the sorted op list) of its producer to the step of its last
+        // consumer. Graph inputs and outputs are pinned for the whole run, so
+        // they stay valid before and after run().
+        std::unordered_map<TensorObj *, size_t> buffers;
+        // byte offset of the tensors written into a slice of a concat output
+        std::unordered_map<TensorObj *, size_t> sliceOffsets;
+        vector<BufferLifetime> lifetimes;
+        size_t nSteps = ops.size();
+        for (auto &tensor : tensors)
+            if (!tensor->getSource() && !tensor->isWeight())
+            {
+                buffers[tensor.get()] = lifetimes.size();
+                lifetimes.push_back(
+                    {allocator.getAlignedSize(tensor->getBytes()), 0, nSteps});
+            }
+        for (size_t i = 0; i < ops.size(); ++i)
         {
-            auto ans = op->inferShape();
-            IT_ASSERT(ans.has_value());
-            auto oldOutputs = op->getOutputs();
-            IT_ASSERT(ans.value().size() == oldOutputs.size());
-            // replace the old outputshape and size with new one
-            for (int i = 0; i < (int)ans.value().size(); ++i)
+            for (auto &input : ops[i]->getInputs())
+            {
+                if (input->isWeight())
+                    continue;
+                auto &lifetime = lifetimes[buffers.at(input.get())];
+                lifetime.end = std::max(lifetime.end, i);
+            }
+            for (auto &output : ops[i]->getOutputs())
             {
-                auto newShape = ans.value()[i];
-                auto oldShape = oldOutputs[i]->getDims();
-                auto fuid = oldOutputs[i]->getFuid();
-                if (newShape != oldShape)
+                if (buffers.find(output.get()) != buffers.end())
+                    continue;
+                bool pinned = isOutput(output);
+                // the producer writes its slice of the (outermost) concat
+                // output, whose block is live from the first such write
+                Tensor root = output;
+                size_t sliceOffset = 0, offset = 0;
+                while (auto concatOutput = getConcatOutput(root, offset))
+                {
+                    root = concatOutput;
+                    sliceOffset += offset;
+                }
+                if (root != output)
+                {
+                    sliceOffsets[output.get()] = sliceOffset;
+                    auto it = buffers.find(root.get());
+                    if (it == buffers.end())
+                    {
+                        bool rootPinned = isOutput(root);
+                        it = buffers.emplace(root.get(), lifetimes.size()).first;
+                        lifetimes.push_back(
+                            {allocator.getAlignedSize(root->getBytes()),
+                             rootPinned ? 0 : i, rootPinned ? nSteps : i});
+                    }
+                    buffers[output.get()] = it->second;
+                    continue;
+                }
+                if (auto input = getInPlaceInput(ops[i], output))
+                {
+                    // the output takes over the block of the dying input
+                    buffers[output.get()] = buffers.at(input.get());
+                    if (pinned)
+                        lifetimes[buffers.at(input.get())].end = nSteps;
+                    continue;
+                }
+                buffers[output.get()] = lifetimes.size();
+                lifetimes.push_back({allocator.getAlignedSize(output->getBytes()),
+                                     pinned ? 0 : i, pinned ? nSteps : i});
+            }
+        }
+
+        // One workspace serves every kernel that asks for scratch memory. It
+        // is live from the first to the last of these ops.
+        ArenaLayout layout;
+        BufferLifetime workspaceLifetime{0, nSteps, 0};
+        for (size_t i = 0; i < ops.size(); ++i)
+            if (auto kernel = findKernel(ops[i]))
+                if (auto size = kernel->getWorkspaceSize(ops[i]))
                 {
-                    auto tensor = this->getTensor(fuid);
-                    tensor->setShape(newShape);
+                    layout.workspaceSize = std::max(layout.workspaceSize, size);
+                    workspaceLifetime.begin = std::min(workspaceLifetime.begin, i);
+                    workspaceLifetime.end = i;
                 }
+        if (layout.workspaceSize > 0)
+        {
+            workspaceLifetime.size = allocator.getAlignedSize(layout.workspaceSize);
+            lifetimes.push_back(workspaceLifetime);
+        }
+
+        allocator.reset();
+        auto plan = MemoryPlanner::plan(lifetimes, strategy, allocator);
+        if (layout.workspaceSize > 0)
+            layout.workspaceOffset = plan.offsets.back();
+        size_t naiveBytes = 0;
+        for (auto &tensor : tensors)
+        {
+            // weights are bound to the weight region instead
+            if (tensor->isWeight())
+            {
+                layout.offsets.emplace_back(0);
+                layout.slices.emplace_back(false);
+                continue;
             }
+            layout.offsets.emplace_back(plan.offsets[buffers.at(tensor.get())]);
+            layout.slices.emplace_back(sliceOffsets.count(tensor.get()) > 0);
+            naiveBytes += allocator.getAlignedSize(tensor->getBytes());
         }
+        auto &report = layout.report;
+        report.strategy = MemoryPlanner::toString(strategy);
+        report.peak = plan.peak;
+        report.lowerBound = plan.lowerBound;
+        report.naiveBytes = naiveBytes;
+        report.workspaceSize = layout.workspaceSize;
+        report.weightBytes = weights->getSize();
+        std::unordered_map<OperatorObj *, size_t> steps;
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            steps[ops[i].get()] = i;
+            report.steps.push_back({i, ops[i]->getGuid(),
+                                    ops[i]->getOpType().toString(), 0, 0, 0.});
+        }
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            const auto &tensor = tensors[i];
+            if (tensor->isWeight())
+                continue;
+            auto source = tensor->getSource();
+            size_t firstUse = source ? steps.at(source.get()) : 0;
+            size_t lastUse = isOutput(tensor) && nSteps > 0
+                                 ? nSteps - 1
+                                 : firstUse;
+            for (auto &target : tensor->getTargets())
+                lastUse = std::max(lastUse, steps.at(target.get()));
+            auto buffer = buffers.at(tensor.get());
+            // an in-place output shares the block of an input of its producer
+            bool inPlace = false;
+            if (source)
+                for (auto &input : source->getInputs())
+                    if (!input->isWeight() && buffers.at(input.get()) == buffer)
+                        inPlace = true;
+            // a concat slice covers only its own part of the root block
+            auto slice = sliceOffsets.find(tensor.get());
+            bool isSlice = slice != sliceOffsets.end();
+            size_t offset = layout.offsets[i] + (isSlice ? slice->second : 0);
+            size_t size = isSlice ? tensor->getBytes() : lifetimes[buffer].size;
+            report.tensors.push_back({tensor->getGuid(), tensor->getFuid(),
+                                      offset, size, firstUse, lastUse,
+                                      inPlace});
+        }
+        report.computeTimeline(lifetimes, plan.offsets, nSteps);
+
+        return layout;
     }
 
-    void GraphObj::dataMalloc()
+    const MemoryReport &GraphObj::getMemoryReport() const
     {
-        // topological sorting first
-        IT_ASSERT(topo_sort() == true);
+        auto it = memoryPlans.find(currentPlan);
+        IT_ASSERT(it != memoryPlans.end(), "No memory plan, call dataMalloc first");
+        return it->second.report;
+    }
 
-        // =================================== 作业 ===================================
-        // TODO：利用 allocator 给计算图分配内存
-        // HINT: 获取分配好的内存指针后，可以调用 tensor 的 setDataBlob 函数给 tensor 绑定内存
-        // =================================== 作业 ===================================
-        // allocator.info();
-        // void* allocatorPtr = allocator.getPtr();
-        // for(auto it = tensors.begin(); it != tensors.end(); it++){
-        //     auto tensor = *it;
-        //     size_t size = tensor->getBytes();
-        //     size_t addr = allocator.alloc(size);
-        //     char * tmpPtr = reinterpret_cast<char*>(allocatorPtr) + addr;
-        //     Blob blob = make_ref<BlobObj>(runtime, (void *)tmpPtr);
-        //     tensor->setDataBlob(blob);
-        // }
-        // topological sorting first
-        IT_ASSERT(topo_sort() == true);
+    string GraphObj::getPlanSignature(MemoryPlanStrategy strategy) const
+    {
+        std::ostringstream oss;
+        oss << MemoryPlanner::toString(strategy);
+        std::unordered_map<string, int> symbolSizes;
+        for (auto &tensor : tensors)
+            if (!tensor->getSource())
+            {
+                const auto &symbols = tensor->getSymbolicDims();
+                for (size_t i = 0; i < symbols.size(); ++i)
+                {
+                    if (symbols[i].empty() || i >= tensor->getRank())
+                        continue;
+                    auto size = tensor->getDims()[i];
+                    auto [it, inserted] = symbolSizes.emplace(symbols[i], size);
+                    IT_ASSERT(inserted || it->second == size,
+                              "Symbolic dim " + symbols[i] +
+                                  " has different sizes");
+                }
+                oss << ";" << vecToString(getPaddedShape(tensor)) << ":"
+                    << tensor->getDType().toString();
+                for (auto &symbol : symbols)
+                    oss << ":" << symbol;
+            }
+        return oss.str();
+    }
 
-        // =================================== 作业 ===================================
-        // TODO：利用 allocator 给计算图分配内存
-        // HINT: 获取分配好的内存指针后，可以调用 tensor 的 setDataBlob 函数给 tensor 绑定内存
-        // =================================== 作业 ===================================
-        vector<size_t> offsets;
-        for (auto tensor : tensors)
+    void GraphObj::setShapeBuckets(const string &symbol, vector<int> buckets)
+    {
+        IT_ASSERT(!buckets.empty() &&
+                  std::is_sorted(buckets.begin(), buckets.end()));
+        memoryPlans.clear();
+        shapeBuckets[symbol] = std::move(buckets);
+    }
+
+    Shape GraphObj::getPaddedShape(const Tensor &tensor) const
+    {
+        auto shape = tensor->getDims();
+        const auto &symbols = tensor->getSymbolicDims();
+        for (size_t i = 0; i < symbols.size() && i < shape.size(); ++i)
         {
-            size_t size = tensor->getBytes();
-            size_t offset = allocator.alloc(size);
-            offsets.push_back(offset);
+            // a symbol without buckets is planned at its size
+            auto it = shapeBuckets.find(symbols[i]);
+            if (symbols[i].empty() || it == shapeBuckets.end())
+                continue;
+            const auto &buckets = it->second;
+            auto bucket = std::lower_bound(buckets.begin(), buckets.end(),
+                                           shape[i]);
+            IT_ASSERT(bucket != buckets.end(),
+                      "Symbolic dim " + symbols[i] + " of size " +
+                          std::to_string(shape[i]) +
+                          " exceeds its largest bucket");
+            shape[i] = *bucket;
         }
-        auto it = offsets.begin();
-        void *basePtr = allocator.getPtr();
-        for (auto tensor : tensors)
+        return shape;
+    }
+
+    Kernel *GraphObj::findKernel(const Operator &op) const
+    {
+        auto kernelAttrs =
+            KernelAttrs{runtime->getDevice(), op->getOpType().underlying()};
+        const auto &kernelRegistry = KernelRegistry::getInstance();
+        if (!kernelRegistry.hasKernel(kernelAttrs))
+            return nullptr;
+        return kernelRegistry.getKernel(kernelAttrs);
+    }
+
+    Tensor GraphObj::getInPlaceInput(const Operator &op, const Tensor &output) const
+    {
+        auto kernel = findKernel(op);
+        if (!kernel || !kernel->isInPlaceSafe())
+            return nullptr;
+        for (auto &input : op->getInputs())
+        {
+            // Graph inputs are pinned. The op must be the only consumer, so the
+            // input dies here; an op reading it twice is listed twice.
+            if (!input->getSource() || input->getTargets().size() != 1 ||
+                isOutput(input))
+                continue;
+            // equal symbols keep the shapes equal at every size of a bucket,
+            // not only at the padded one the plan is made for
+            if (input->getDims() == output->getDims() &&
+                input->getSymbolicDims() == output->getSymbolicDims() &&
+                input->getDType() == output->getDType())
+                return input;
+        }
+        return nullptr;
+    }
+
+    Tensor GraphObj::getConcatOutput(const Tensor &tensor, size_t &offset) const
+    {
+        // graph inputs are set by the caller, weights live in their region,
+        // and an output must survive the reuse of the concat block
+        const auto &targets = tensor->getTargets();
+        if (!tensor->getSource() || tensor->isWeight() || targets.size() != 1 ||
+            isOutput(tensor) ||
+            targets[0]->getOpType() != OpType::Concat)
+            return nullptr;
+        auto concat = as<ConcatObj>(targets[0]);
+        auto output = concat->getOutput();
+        const auto &dims = output->getDims();
+        for (int i = 0; i < concat->getDim(); ++i)
+            if (dims[i] != 1)
+                return nullptr;
+        offset = 0;
+        for (auto &input : concat->getInputs())
         {
-            char *charPtr = reinterpret_cast<char *>(basePtr) + *it;
-            void *ptr = charPtr;
-            Blob blob = make_ref<BlobObj>(runtime, ptr);
-            tensor->setDataBlob(blob);
-            it++;
+            if (input == tensor)
+                return output;
+            offset += input->getBytes();
         }
-        allocator.info();
+        return nullptr;
+    }
+
+    void GraphObj::setInputs(const TensorVec &inputs)
+    {
+        for (auto &tensor : inputs)
+            IT_ASSERT(contains(tensor) && !tensor->getSource(),
+                      "A graph input must be a tensor of the graph without a "
+                      "producer");
+        invalidate();
+        declaredInputs = inputs;
+    }
+
+    void GraphObj::setOutputs(const TensorVec &outputs)
+    {
+        for (auto &tensor : outputs)
+            IT_ASSERT(contains(tensor), "A graph output must be a tensor of "
+                                        "the graph");
+        invalidate();
+        declaredOutputs = outputs;
+    }
+
+    bool GraphObj::isInput(const Tensor &tensor) const
+    {
+        if (!declaredInputs)
+            return !tensor->getSource();
+        return std::find(declaredInputs->begin(), declaredInputs->end(),
+                         tensor) != declaredInputs->end();
+    }
+
+    bool GraphObj::isOutput(const Tensor &tensor) const
+    {
+        if (!declaredOutputs)
+            return tensor->getTargets().empty();
+        return std::find(declaredOutputs->begin(), declaredOutputs->end(),
+                         tensor) != declaredOutputs->end();
+    }
+
+    bool GraphObj::isUnused(const Tensor &tensor) const
+    {
+        return tensor->getTargets().empty() &&
+               !(declaredOutputs && isOutput(tensor));
     }
 
     Tensor GraphObj::addTensor(Shape dim, DataType dtype)
     {
-        return tensors.emplace_back(make_ref<TensorObj>(dim, dtype, runtime));
+        invalidate();
+        auto tensor = make_ref<TensorObj>(dim, dtype, runtime);
+        tensorIndex.emplace(tensor->getFuid(), tensors.size());
+        return tensors.emplace_back(tensor);
     }
 
     Tensor GraphObj::addTensor(const Tensor &tensor)
@@ -358,6 +854,8 @@ namespace infini
                   std::string("Tensor runtime mismatch: cannot add a tenosr in ") +
                       tensor->getRuntime()->toString() + " to " +
                       runtime->toString());
+        invalidate();
+        tensorIndex.emplace(tensor->getFuid(), tensors.size());
         tensors.emplace_back(tensor);
         return tensor;
     }
@@ -375,46 +873,43 @@ namespace infini
     // "predecessors" and "successors" of an operator of "ops" must be in "ops".
     bool GraphObj::checkValid() const
     {
+        compact();
+        for (auto &tensor : getInputs())
+            IT_ASSERT(contains(tensor) && !tensor->getSource());
+        for (auto &tensor : getOutputs())
+            IT_ASSERT(contains(tensor));
         for (auto tensor : tensors)
         {
             IT_ASSERT(!(tensor->getTargets().size() == 0 &&
                         nullptr == tensor->getSource()));
             for (auto op : tensor->getTargets())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), op) != ops.end());
+                IT_ASSERT(contains(op));
             }
             auto op = tensor->getSource();
-            IT_ASSERT(!(op && std::find(ops.begin(), ops.end(), op) == ops.end()));
+            IT_ASSERT(!(op && !contains(op)));
         }
         for (auto op : ops)
         {
             for (auto tensor : op->getInputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(contains(tensor));
             }
             for (auto tensor : op->getOutputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(contains(tensor));
             }
             for (auto pre : op->getPredecessors())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), pre) != ops.end());
+                IT_ASSERT(contains(pre));
             }
             for (auto suc : op->getSuccessors())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), suc) != ops.end());
+                IT_ASSERT(contains(suc));
             }
         }
-        std::set<UidBaseType> s;
         // check whether two tensors with the same FUID exist
-        for (auto tensor : tensors)
-        {
-            int cnt = s.count(tensor->getFuid());
-            IT_ASSERT(cnt == 0, std::to_string(tensor->getFuid()));
-            s.insert(tensor->getFuid());
-        }
+        IT_ASSERT(tensorIndex.size() == tensors.size());
         return true;
     }
 
@@ -0,0 +1,502 @@
+#include "core/graph_serializer.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/fused_element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace infini
+{
+    namespace
+    {
+        constexpr char magic[8] = {'I', 'T', 'G', 'R', 'A', 'P', 'H', '\0'};
+        constexpr uint32_t version = 1;
+
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            // alignment of the graph, every weight offset is a multiple
+            uint32_t alignment;
+            uint64_t weightOffset;
+            uint64_t weightBytes;
+        };
+
+        size_t alignUp(size_t size, size_t alignment)
+        {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        class Writer
+        {
+        public:
+            std::string bytes;
+
+            template <typename T>
+            void put(const T &value)
+            {
+                bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+            }
+            void putString(const string &value)
+            {
+                put<uint32_t>(value.size());
+                bytes.append(value);
+            }
+            void putInts(const vector<int> &values)
+            {
+                put<uint32_t>(values.size());
+                for (auto value : values)
+                    put<int32_t>(value);
+            }
+            void putOptional(const optional<float> &value)
+            {
+                put<uint8_t>(value.has_value());
+                put<float>(value.value_or(0.f));
+            }
+        };
+
+        class Reader
+        {
+            const char *ptr;
+            size_t size;
+            size_t pos = 0;
+
+        public:
+            Reader(const char *ptr, size_t size) : ptr(ptr), size(size) {}
+
+            size_t remaining() const { return size - pos; }
+
+            template <typename T>
+            T get()
+            {
+                IT_ASSERT(pos + sizeof(T) <= size, "Truncated graph file");
+                T value;
+                std::memcpy(&value, ptr + pos, sizeof(T));
+                pos += sizeof(T);
+                return value;
+            }
+            // a count of items of at least `itemBytes` each, checked against
+            // the bytes left before anything is allocated for them
+            template <typename T>
+            size_t getCount(size_t itemBytes)
+            {
+                auto count = get<T>();
+                IT_ASSERT(count <= remaining() / itemBytes,
+                          "Truncated graph file");
+                return count;
+            }
+            string getString()
+            {
+                auto length = getCount<uint32_t>(1);
+                string value(ptr + pos, length);
+                pos += length;
+                return value;
+            }
+            vector<int> getInts()
+            {
+                vector<int> values(getCount<uint32_t>(sizeof(int32_t)));
+                for (auto &value : values)
+                    value = get<int32_t>();
+                return values;
+            }
+            optional<float> getOptional()
+            {
+                bool has = get<uint8_t>();
+                auto value = get<float>();
+                return has ? optional<float>(value) : std::nullopt;
+            }
+        };
+
+        void putAttributes(Writer &writer, const Operator &op)
+        {
+            switch (op->getOpType().underlying())
+            {
+            case OpType::Add:
+            case OpType::Sub:
+            case OpType::Mul:
+            case OpType::Div:
+            case OpType::Relu:
+                break;
+            case OpType::Clip:
+            {
+                auto clip = as<ClipObj>(op);
+                writer.putOptional(clip->getMin());
+                writer.putOptional(clip->getMax());
+                break;
+            }
+            case OpType::Cast:
+                writer.put<int32_t>(enum_to_underlying(as<CastObj>(op)->getType()));
+                break;
+            case OpType::Transpose:
+                writer.putInts(as<TransposeObj>(op)->getPermute());
+                break;
+            case OpType::Concat:
+                writer.put<int32_t>(as<ConcatObj>(op)->getDim());
+                break;
+            case OpType::MatMul:
+            {
+                auto matmul = as<MatmulObj>(op);
+                writer.put<uint8_t>(matmul->getTransA());
+                writer.put<uint8_t>(matmul->getTransB());
+                writer.put<uint8_t>(enum_to_underlying(matmul->getAct()));
+                writer.putOptional(matmul->getClipMin());
+                writer.putOptional(matmul->getClipMax());
+                break;
+            }
+            case OpType::FusedElementWise:
+            {
+                const auto &steps = as<FusedElementWiseObj>(op)->getSteps();
+                writer.put<uint32_t>(steps.size());
+                for (auto &step : steps)
+                {
+                    writer.put<uint16_t>(step.type.underlying());
+                    writer.put<int32_t>(step.lhs);
+                    writer.put<int32_t>(step.rhs);
+                    writer.putOptional(step.min);
+                    writer.putOptional(step.max);
+                }
+                break;
+            }
+            default:
+                IT_TODO_HALT_MSG("Saving " + op->getOpType().toString() +
+                                 " is not supported");
+            }
+        }
+
+        void addOp(const Graph &graph, OpType type, const TensorVec &inputs,
+                   const Tensor &output, Reader &reader)
+        {
+            switch (type.underlying())
+            {
+            case OpType::Add:
+                graph->addOpWithOutputs<AddObj>(inputs[0], inputs[1], output);
+                break;
+            case OpType::Sub:
+                graph->addOpWithOutputs<SubObj>(inputs[0], inputs[1], output);
+                break;
+            case OpType::Mul:
+                graph->addOpWithOutputs<MulObj>(inputs[0], inputs[1], output);
+                break;
+            case OpType::Div:
+                graph->addOpWithOutputs<DivObj>(inputs[0], inputs[1], output);
+                break;
+            case OpType::Relu:
+                graph->addOpWithOutputs<ReluObj>(inputs[0], output);
+                break;
+            case OpType::Clip:
+            {
+                auto min = reader.getOptional();
+                auto max = reader.getOptional();
+                graph->addOpWithOutputs<ClipObj>(inputs[0], output, min, max);
+                break;
+            }
+            case OpType::Cast:
+            {
+                auto castType = reader.get<int32_t>();
+                IT_ASSERT(castType >= 0 &&
+                              castType <= enum_to_underlying(CastType::Float2Float),
+                          "Unknown cast type in graph file");
+                graph->addOpWithOutputs<CastObj>(inputs[0], output,
+                                                 CastType(castType));
+                break;
+            }
+            case OpType::Transpose:
+            {
+                auto permute = reader.getInts();
+                vector<bool> seen(permute.size());
+                for (auto axis : permute)
+                {
+                    IT_ASSERT(axis >= 0 && axis < (int)permute.size() &&
+                                  !seen[axis],
+                              "Bad permutation in graph file");
+                    seen[axis] = true;
+                }
+                graph->addOpWithOutputs<TransposeObj>(inputs[0], output,
+                                                      std::move(permute));
+                break;
+            }
+            case OpType::Concat:
+                graph->addOpWithOutputs<ConcatObj>(inputs, output,
+                                                   reader.get<int32_t>());
+                break;
+            case OpType::MatMul:
+            {
+                bool transA = reader.get<uint8_t>();
+                bool transB = reader.get<uint8_t>();
+                auto actIndex = reader.get<uint8_t>();
+                IT_ASSERT(actIndex <= enum_to_underlying(ActType::Clip),
+                          "Unknown activation in graph file");
+                auto act = ActType(actIndex);
+                auto clipMin = reader.getOptional();
+                auto clipMax = reader.getOptional();
+                graph->addOpWithOutputs<MatmulObj>(
+                    inputs[0], inputs[1], output, transA, transB,
+                    inputs.size() > 2 ? inputs[2] : nullptr, act, clipMin,
+                    clipMax);
+                break;
+            }
+            case OpType::FusedElementWise:
+            {
+                vector<FusedElementWiseStep> steps;
+                auto nSteps = reader.getCount<uint32_t>(20);
+                for (size_t i = 0; i < nSteps; ++i)
+                {
+                    auto stepType = OpType(reader.get<uint16_t>());
+                    IT_ASSERT(stepType == OpType::Add || stepType == OpType::Sub ||
+                                  stepType == OpType::Mul ||
+                                  stepType == OpType::Div ||
+                                  stepType == OpType::Relu ||
+                                  stepType == OpType::Clip,
+                              "Unknown fused step in graph file");
+                    int lhs = reader.get<int32_t>();
+                    int rhs = reader.get<int32_t>();
+                    auto min = reader.getOptional();
+                    auto max = reader.getOptional();
+                    steps.push_back({stepType, lhs, rhs, min, max});
+                }
+                graph->addOpWithOutputs<FusedElementWiseObj>(inputs, output,
+                                                             steps);
+                break;
+            }
+            default:
+                IT_ASSERT(false, "Unknown op type in graph file");
+            }
+        }
+
+        // inputs each op type reads, checked before addOp indexes them
+        bool hasValidInputs(OpType type, size_t nInputs)
+        {
+            switch (type.underlying())
+            {
+            case OpType::Add:
+            case OpType::Sub:
+            case OpType::Mul:
+            case OpType::Div:
+                return nInputs == 2;
+            case OpType::Relu:
+            case OpType::Clip:
+            case OpType::Cast:
+            case OpType::Transpose:
+                return nInputs == 1;
+            case OpType::MatMul:
+                return nInputs == 2 || nInputs == 3;
+            case OpType::Concat:
+            case OpType::FusedElementWise:
+                return nInputs >= 1;
+            default:
+                IT_ASSERT(false, "Unknown op type in graph file");
+            }
+            return false;
+        }
+
+        size_t getPageSize() { return sysconf(_SC_PAGESIZE); }
+    } // namespace
+
+    void GraphSerializer::save(const Graph &graph, const string &path)
+    {
+        IT_ASSERT(graph->topo_sort() == true);
+        const auto &tensors = graph->getTensors();
+        std::unordered_map<TensorObj *, uint64_t> indices;
+        for (size_t i = 0; i < tensors.size(); ++i)
+            indices.emplace(tensors[i].get(), i);
+        auto putTensors = [&](Writer &writer, const TensorVec &list)
+        {
+            writer.put<uint32_t>(list.size());
+            for (auto &tensor : list)
+                writer.put<uint64_t>(indices.at(tensor.get()));
+        };
+
+        Writer writer;
+        size_t alignment = graph->getAlignment(), weightBytes = 0;
+        TensorVec weights;
+        vector<size_t> weightOffsets;
+        writer.put<uint64_t>(tensors.size());
+        for (auto &tensor : tensors)
+        {
+            writer.put<int32_t>(tensor->getDType().getIndex());
+            writer.put<uint8_t>(tensor->isWeight());
+            writer.putInts(tensor->getDims());
+            const auto &symbols = tensor->getSymbolicDims();
+            writer.put<uint32_t>(symbols.size());
+            for (auto &symbol : symbols)
+                writer.putString(symbol);
+            if (!tensor->isWeight())
+                continue;
+            IT_ASSERT(tensor->hasData(), "Weights must hold data to be saved");
+            weightBytes = alignUp(weightBytes, alignment);
+            writer.put<uint64_t>(weightBytes);
+            weights.emplace_back(tensor);
+            weightOffsets.emplace_back(weightBytes);
+            weightBytes += tensor->getBytes();
+        }
+        const auto &ops = graph->getOperators();
+        writer.put<uint64_t>(ops.size());
+        for (auto &op : ops)
+        {
+            writer.put<uint16_t>(op->getOpType().underlying());
+            putTensors(writer, op->getInputs());
+            putTensors(writer, op->getOutputs());
+            putAttributes(writer, op);
+        }
+        // only a declared boundary is kept, an inferred one is inferred
+        // again from the loaded ops
+        writer.put<uint8_t>(graph->hasDeclaredInputs());
+        if (graph->hasDeclaredInputs())
+            putTensors(writer, graph->getInputs());
+        writer.put<uint8_t>(graph->hasDeclaredOutputs());
+        if (graph->hasDeclaredOutputs())
+            putTensors(writer, graph->getOutputs());
+
+        Header header;
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.alignment = alignment;
+        header.weightOffset =
+            alignUp(sizeof(Header) + writer.bytes.size(), getPageSize());
+        header.weightBytes = weightBytes;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        IT_ASSERT(file.good(), "Can not open " + path);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        file.write(writer.bytes.data(), writer.bytes.size());
+        size_t pos = sizeof(Header) + writer.bytes.size();
+        auto padTo = [&](size_t target)
+        {
+            string zeros(target - pos, '\0');
+            file.write(zeros.data(), zeros.size());
+            pos = target;
+        };
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            padTo(header.weightOffset + weightOffsets[i]);
+            file.write(weights[i]->getRawDataPtr<const char *>(),
+                       weights[i]->getBytes());
+            pos += weights[i]->getBytes();
+        }
+        padTo(header.weightOffset + weightBytes);
+        IT_ASSERT(file.good(), "Failed to write " + path);
+    }
+
+    Graph GraphSerializer::load(const Runtime &runtime, const string &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        IT_ASSERT(fd >= 0, "Can not open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header))
+        {
+            close(fd);
+            IT_ASSERT(false, "Not a graph file: " + path);
+        }
+        size_t size = st.st_size;
+        // private and writable, so a weight can still be overwritten without
+        // touching the file
+        void *base =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        IT_ASSERT(base != MAP_FAILED, "Can not map " + path);
+        std::shared_ptr<void> mapping(base,
+                                      [size](void *ptr) { munmap(ptr, size); });
+        auto bytes = static_cast<char *>(base);
+
+        Header header;
+        std::memcpy(&header, bytes, sizeof(Header));
+        IT_ASSERT(std::memcmp(header.magic, magic, sizeof(magic)) == 0,
+                  "Not a graph file: " + path);
+        IT_ASSERT(header.version == version, "Unsupported graph file version");
+        IT_ASSERT(header.alignment >= sizeof(uint64_t) &&
+                      (header.alignment & (header.alignment - 1)) == 0,
+                  "Bad alignment in graph file");
+        IT_ASSERT(header.weightOffset >= sizeof(Header) &&
+                      header.weightOffset <= size &&
+                      header.weightBytes <= size - header.weightOffset,
+                  "Truncated graph file");
+        Reader reader(bytes + sizeof(Header),
+                      header.weightOffset - sizeof(Header));
+
+        Graph graph = make_ref<GraphObj>(runtime, header.alignment);
+        // dtype, weight flag and the counts of dims and symbols
+        TensorVec tensors(reader.getCount<uint64_t>(13));
+        vector<std::pair<Tensor, size_t>> weights;
+        for (auto &tensor : tensors)
+        {
+            auto dtypeIndex = reader.get<int32_t>();
+            IT_ASSERT(dtypeIndex > 0 &&
+                          dtypeIndex < (int)std::size(DataType::cpuType) &&
+                          DataType::cpuType[dtypeIndex] >= 0,
+                      "Unknown data type in graph file");
+            bool isWeight = reader.get<uint8_t>();
+            auto dims = reader.getInts();
+            size_t elements = 1;
+            for (auto dim : dims)
+            {
+                IT_ASSERT(dim >= 0 && (dim == 0 || elements <= SIZE_MAX / dim),
+                          "Bad shape in graph file");
+                elements *= dim;
+            }
+            tensor = graph->addTensor(dims, DataType(dtypeIndex));
+            auto nSymbols = reader.getCount<uint32_t>(sizeof(uint32_t));
+            IT_ASSERT(nSymbols == 0 || nSymbols == dims.size(),
+                      "Bad symbols in graph file");
+            for (size_t i = 0; i < nSymbols; ++i)
+                if (auto symbol = reader.getString(); !symbol.empty())
+                    tensor->setSymbolicDim(i, symbol);
+            if (!isWeight)
+                continue;
+            tensor->setWeight();
+            auto offset = reader.get<uint64_t>();
+            IT_ASSERT(elements <= header.weightBytes / tensor->getDType().getSize() &&
+                          offset <= header.weightBytes - tensor->getBytes(),
+                      "Truncated graph file");
+            IT_ASSERT(offset % header.alignment == 0,
+                      "Misaligned weight in graph file");
+            weights.emplace_back(tensor, offset);
+        }
+        auto getTensors = [&]()
+        {
+            TensorVec list(reader.getCount<uint32_t>(sizeof(uint64_t)));
+            for (auto &tensor : list)
+            {
+                auto index = reader.get<uint64_t>();
+                IT_ASSERT(index < tensors.size(), "Bad tensor in graph file");
+                tensor = tensors[index];
+            }
+            return list;
+        };
+        // type and the counts of inputs and outputs
+        auto nOps = reader.getCount<uint64_t>(10);
+        for (size_t i = 0; i < nOps; ++i)
+        {
+            auto type = OpType(reader.get<uint16_t>());
+            auto inputs = getTensors();
+            auto outputs = getTensors();
+            IT_ASSERT(hasValidInputs(type, inputs.size()) && outputs.size() == 1,
+                      "Bad op in graph file");
+            addOp(graph, type, inputs, outputs[0], reader);
+        }
+        if (reader.get<uint8_t>())
+            graph->setInputs(getTensors());
+        if (reader.get<uint8_t>())
+            graph->setOutputs(getTensors());
+
+        // the weights read the mapping in place; the mapping starts on a page
+        // and the weight section as far into it as the saving host's page
+        size_t alignment =
+            std::min<size_t>({header.alignment, getPageSize(),
+                              header.weightOffset & (~header.weightOffset + 1)});
+        for (auto &[tensor, offset] : weights)
+            graph->getWeightRegion()->bindExternal(
+                tensor, bytes + header.weightOffset + offset, alignment,
+                mapping);
+        return graph;
+    }
+
+} // namespace infini
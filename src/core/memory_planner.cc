@@ -0,0 +1,139 @@
+#include "core/memory_planner.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+
+namespace infini
+{
+    MemoryPlan MemoryPlanner::plan(const vector<BufferLifetime> &lifetimes,
+                                   MemoryPlanStrategy strategy,
+                                   Allocator &allocator)
+    {
+        MemoryPlan plan;
+        switch (strategy)
+        {
+        case MemoryPlanStrategy::Online:
+            plan.offsets = planOnline(lifetimes, allocator);
+            plan.peak = allocator.getPeak();
+            break;
+        case MemoryPlanStrategy::GreedyBySize:
+            plan.offsets = planGreedyBySize(lifetimes, plan.peak);
+            // the offline layout lives in one block at the head of the arena
+            if (plan.peak > 0)
+            {
+                auto head = allocator.alloc(plan.peak);
+                IT_ASSERT(head == 0);
+            }
+            break;
+        default:
+            IT_TODO_HALT();
+        }
+        plan.lowerBound = getLowerBound(lifetimes);
+        return plan;
+    }
+
+    vector<size_t>
+    MemoryPlanner::planOnline(const vector<BufferLifetime> &lifetimes,
+                              Allocator &allocator)
+    {
+        size_t nSteps = 0;
+        for (auto &lifetime : lifetimes)
+            nSteps = std::max(nSteps, lifetime.end + 1);
+        // bucket the events by step, allocations of a step go before its frees
+        vector<vector<size_t>> allocAt(nSteps), freeAt(nSteps);
+        for (size_t i = 0; i < lifetimes.size(); ++i)
+        {
+            allocAt[lifetimes[i].begin].emplace_back(i);
+            freeAt[lifetimes[i].end].emplace_back(i);
+        }
+        vector<size_t> offsets(lifetimes.size());
+        for (size_t step = 0; step < nSteps; ++step)
+        {
+            for (auto i : allocAt[step])
+                offsets[i] = allocator.alloc(lifetimes[i].size);
+            for (auto i : freeAt[step])
+                allocator.free(offsets[i], lifetimes[i].size);
+        }
+        return offsets;
+    }
+
+    vector<size_t>
+    MemoryPlanner::planGreedyBySize(const vector<BufferLifetime> &lifetimes,
+                                    size_t &peak)
+    {
+        vector<size_t> order(lifetimes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return lifetimes[a].size > lifetimes[b].size; });
+
+        vector<size_t> offsets(lifetimes.size());
+        // placed buffers as (offset, index), ordered by offset
+        std::multimap<size_t, size_t> placed;
+        peak = 0;
+        for (auto i : order)
+        {
+            const auto &cur = lifetimes[i];
+            size_t prevEnd = 0, best = 0;
+            size_t bestGap = std::numeric_limits<size_t>::max();
+            bool found = false;
+            for (auto &[offset, j] : placed)
+            {
+                const auto &other = lifetimes[j];
+                if (other.end < cur.begin || cur.end < other.begin)
+                    continue;
+                // a gap between two overlapping buffers, keep the tightest
+                if (offset > prevEnd)
+                {
+                    size_t gap = offset - prevEnd;
+                    if (gap >= cur.size && gap < bestGap)
+                    {
+                        bestGap = gap;
+                        best = prevEnd;
+                        found = true;
+                    }
+                }
+                prevEnd = std::max(prevEnd, offset + other.size);
+            }
+            offsets[i] = found ? best : prevEnd;
+            placed.emplace(offsets[i], i);
+            peak = std::max(peak, offsets[i] + cur.size);
+        }
+        return offsets;
+    }
+
+    size_t MemoryPlanner::getLowerBound(const vector<BufferLifetime> &lifetimes)
+    {
+        size_t nSteps = 0;
+        for (auto &lifetime : lifetimes)
+            nSteps = std::max(nSteps, lifetime.end + 1);
+        // difference array over the steps, then a prefix sum
+        vector<long long> delta(nSteps + 1, 0);
+        for (auto &lifetime : lifetimes)
+        {
+            delta[lifetime.begin] += lifetime.size;
+            delta[lifetime.end + 1] -= lifetime.size;
+        }
+        long long live = 0, maxLive = 0;
+        for (size_t step = 0; step < nSteps; ++step)
+        {
+            live += delta[step];
+            maxLive = std::max(maxLive, live);
+        }
+        return maxLive;
+    }
+
+    const char *MemoryPlanner::toString(MemoryPlanStrategy strategy)
+    {
+        switch (strategy)
+        {
+        case MemoryPlanStrategy::Online:
+            return "online";
+        case MemoryPlanStrategy::GreedyBySize:
+            return "greedy-by-size";
+        default:
+            return "unknown";
+        }
+    }
+
+} // namespace infini
@@ -0,0 +1,105 @@
+#include "core/memory_report.h"
+#include "core/memory_planner.h"
+#include <algorithm>
+#include <set>
+
+namespace infini
+{
+    void MemoryReport::computeTimeline(const vector<BufferLifetime> &lifetimes,
+                                       const vector<size_t> &offsets,
+                                       size_t nSteps)
+    {
+        IT_ASSERT(steps.size() == nSteps);
+        // sweep the steps, keeping the end offsets of the live blocks
+        vector<vector<size_t>> beginAt(nSteps + 1), endAfter(nSteps + 1);
+        for (size_t i = 0; i < lifetimes.size(); ++i)
+        {
+            beginAt[std::min(lifetimes[i].begin, nSteps)].emplace_back(i);
+            endAfter[std::min(lifetimes[i].end, nSteps)].emplace_back(i);
+        }
+        std::multiset<size_t> ends;
+        size_t live = 0;
+        for (size_t step = 0; step < nSteps; ++step)
+        {
+            for (auto i : beginAt[step])
+            {
+                live += lifetimes[i].size;
+                ends.insert(offsets[i] + lifetimes[i].size);
+            }
+            auto &record = steps[step];
+            record.liveBytes = live;
+            record.extentBytes = ends.empty() ? 0 : *ends.rbegin();
+            record.fragmentation =
+                record.extentBytes == 0
+                    ? 0.
+                    : 1. - (double)live / (double)record.extentBytes;
+            if (record.extentBytes > steps[peakStep].extentBytes)
+                peakStep = step;
+            for (auto i : endAfter[step])
+            {
+                live -= lifetimes[i].size;
+                ends.erase(ends.find(offsets[i] + lifetimes[i].size));
+            }
+        }
+    }
+
+    const StepMemoryRecord &MemoryReport::getPeakStep() const
+    {
+        IT_ASSERT(!steps.empty(), "Empty memory report");
+        return steps.at(peakStep);
+    }
+
+    string MemoryReport::toJson() const
+    {
+        std::ostringstream oss;
+        oss << "{\"strategy\":\"" << strategy << "\",\"peak\":" << peak
+            << ",\"lowerBound\":" << lowerBound
+            << ",\"naiveBytes\":" << naiveBytes << ",\"peakStep\":" << peakStep
+            << ",\"workspaceSize\":" << workspaceSize
+            << ",\"weightBytes\":" << weightBytes << ",\"tensors\":[";
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            const auto &t = tensors[i];
+            oss << (i ? "," : "") << "{\"guid\":" << t.guid
+                << ",\"fuid\":" << t.fuid << ",\"offset\":" << t.offset
+                << ",\"size\":" << t.size << ",\"firstUse\":" << t.firstUse
+                << ",\"lastUse\":" << t.lastUse
+                << ",\"inPlace\":" << (t.inPlace ? "true" : "false") << "}";
+        }
+        oss << "],\"steps\":[";
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            const auto &s = steps[i];
+            oss << (i ? "," : "") << "{\"step\":" << s.step
+                << ",\"opGuid\":" << s.opGuid << ",\"opType\":\"" << s.opType
+                << "\",\"liveBytes\":" << s.liveBytes
+                << ",\"extentBytes\":" << s.extentBytes
+                << ",\"fragmentation\":" << s.fragmentation << "}";
+        }
+        oss << "]}";
+        return oss.str();
+    }
+
+    string MemoryReport::tensorsToCsv() const
+    {
+        std::ostringstream oss;
+        oss << "guid,fuid,offset,size,firstUse,lastUse,inPlace\n";
+        for (const auto &t : tensors)
+            oss << t.guid << "," << t.fuid << "," << t.offset << "," << t.size
+                << "," << t.firstUse << "," << t.lastUse << "," << t.inPlace
+                << "\n";
+        return oss.str();
+    }
+
+    string MemoryReport::stepsToCsv() const
+    {
+        std::ostringstream oss;
+        oss << "step,opGuid,opType,liveBytes,extentBytes,fragmentation\n";
+        for (const auto &s : steps)
+            oss << s.step << "," << s.opGuid << "," << s.opType << ","
+                << s.liveBytes << "," << s.extentBytes << "," << s.fragmentation
+                << "\n";
+        return oss.str();
+    }
+
+} // namespace infini
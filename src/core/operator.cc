@@ -82,4 +82,36 @@ namespace infini
         return inferDataType(inputs);
     }
 
+    vector<vector<string>>
+    OperatorObj::inferSymbols(const TensorVec &inputs) const
+    {
+        bool symbolic = false;
+        for (auto &input : inputs)
+            symbolic |= !input->getSymbolicDims().empty();
+        vector<vector<string>> ans;
+        for (size_t i = 0; i < outputs.size(); ++i)
+        {
+            const auto &output = outputs[i];
+            if (!symbolic)
+                ans.emplace_back();
+            else if (output->getDims() == inputs[0]->getDims())
+                ans.emplace_back(inputs[0]->getSymbolicDims());
+            else
+            {
+                // unknown to each other and to every input symbol
+                vector<string> names(output->getRank());
+                for (size_t d = 0; d < names.size(); ++d)
+                    names[d] = type.toString() + std::to_string(guid) + "." +
+                               std::to_string(i) + "." + std::to_string(d);
+                ans.emplace_back(std::move(names));
+            }
+        }
+        return ans;
+    }
+
+    vector<vector<string>> OperatorObj::inferSymbols() const
+    {
+        return inferSymbols(inputs);
+    }
+
 } // namespace infini
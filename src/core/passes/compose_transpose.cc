@@ -0,0 +1,56 @@
+#include "core/graph.h"
+#include "operators/transpose.h"
+
+namespace infini
+{
+    /**
+     * @brief Compose chains of transposes into one and drop the identities.
+     * A transpose reading another transpose reads the input of the first one
+     * with the composed permutation instead; the first one goes away once no
+     * other op reads its output. A transpose left with the identity
+     * permutation is bypassed, unless it produces a graph output.
+     */
+    class ComposeTranspose : public GraphPass
+    {
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            // sorted, so a whole chain collapses into its last transpose in
+            // one run
+            for (auto &op : OpVec(graph.getOperators()))
+            {
+                if (op->getOpType() != OpType::Transpose)
+                    continue;
+                auto second = as<TransposeObj>(op);
+                auto mid = second->getInputs(0);
+                auto source = mid->getSource();
+                if (source && source->getOpType() == OpType::Transpose)
+                {
+                    // output dim i is input dim first[second[i]]
+                    auto first = as<TransposeObj>(source);
+                    auto p1 = first->getPermute(), p2 = second->getPermute();
+                    vector<int> composed(p2.size());
+                    for (size_t i = 0; i < p2.size(); ++i)
+                        composed[i] = p1[p2[i]];
+                    second->setPermute(composed);
+                    graph.replaceInput(second, mid, first->getInputs(0));
+                    if (graph.isUnused(mid))
+                        graph.eraseOperator(first);
+                    ++rewrites;
+                }
+                auto output = second->getOutput();
+                if (second->isIdentity() && !graph.isOutput(output))
+                {
+                    graph.replaceAllUses(output, second->getInputs(0));
+                    graph.eraseOperator(second);
+                    ++rewrites;
+                }
+            }
+            return rewrites;
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(ComposeTranspose, "compose-transpose", 100, 1);
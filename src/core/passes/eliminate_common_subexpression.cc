@@ -0,0 +1,75 @@
+#include "core/graph.h"
+
+namespace infini
+{
+    /**
+     * @brief Merge operators of the same type that read the same inputs with
+     * equal attributes, e.g. one tensor transposed the same way for several
+     * branches. The readers of the duplicate read the outputs of the first
+     * one instead, unless either of them produces a graph output.
+     */
+    class EliminateCommonSubexpression : public GraphPass
+    {
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            // sorted, so the inputs of an op are already merged when it is
+            // looked up and a whole duplicated chain goes in one run
+            if (!graph.topo_sort())
+                return 0;
+            std::unordered_map<size_t, OpVec> seen;
+            for (auto &op : OpVec(graph.getOperators()))
+            {
+                auto &bucket = seen[hash(op)];
+                auto it = std::find_if(bucket.begin(), bucket.end(),
+                                       [&](const Operator &other)
+                                       { return isSame(op, other); });
+                if (it == bucket.end())
+                {
+                    bucket.emplace_back(op);
+                    continue;
+                }
+                // merging either op would drop a graph output
+                auto outputs = op->getOutputs();
+                if (hasGraphOutput(graph, op) || hasGraphOutput(graph, *it))
+                    continue;
+                for (size_t i = 0; i < outputs.size(); ++i)
+                    graph.replaceAllUses(outputs[i], (*it)->getOutput(i));
+                graph.eraseOperator(op);
+                ++rewrites;
+            }
+            return rewrites;
+        }
+
+    private:
+        static bool hasGraphOutput(const GraphObj &graph, const Operator &op)
+        {
+            for (auto &output : op->getOutputs())
+                if (graph.isOutput(output))
+                    return true;
+            return false;
+        }
+
+        static size_t hash(const Operator &op)
+        {
+            size_t seed = op->getOpType().underlying();
+            for (auto &input : op->getInputs())
+                hash_combine(seed, input->getFuid());
+            hash_combine(seed, op->hashAttributes());
+            return seed;
+        }
+
+        static bool isSame(const Operator &a, const Operator &b)
+        {
+            return a->getOpType() == b->getOpType() &&
+                   a->getInputs() == b->getInputs() &&
+                   a->getOutputs().size() == b->getOutputs().size() &&
+                   a->equalAttributes(*b);
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(EliminateCommonSubexpression,
+                    "eliminate-common-subexpression", 75, 1);
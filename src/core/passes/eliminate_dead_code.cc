@@ -0,0 +1,58 @@
+#include "core/graph.h"
+#include "core/weight_region.h"
+
+namespace infini
+{
+    /**
+     * @brief Remove the ops none of whose outputs reaches a graph output, and
+     * the tensors left without producer and consumer that are not graph
+     * inputs. Without declared outputs every unread tensor is an output, so
+     * only graphs with GraphObj::setOutputs lose ops.
+     */
+    class EliminateDeadCode : public GraphPass
+    {
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            if (!graph.topo_sort())
+                return 0;
+            auto ops = graph.getOperators();
+            // consumers first, so a whole dead chain goes in one run
+            for (auto it = ops.rbegin(); it != ops.rend(); ++it)
+            {
+                const auto &outputs = (*it)->getOutputs();
+                if (std::all_of(outputs.begin(), outputs.end(),
+                                [&](const Tensor &output)
+                                { return isDead(graph, output); }))
+                {
+                    graph.eraseOperator(*it);
+                    ++rewrites;
+                }
+            }
+            for (auto &tensor : TensorVec(graph.getTensors()))
+                if (!tensor->getSource() && isDead(graph, tensor) &&
+                    !graph.isInput(tensor))
+                {
+                    graph.removeTensor(tensor);
+                    // a weight placed before optimize gives its block back
+                    if (tensor->isWeight() && !graph.sharesWeightRegion() &&
+                        graph.getWeightRegion()->contains(tensor))
+                        graph.getWeightRegion()->release(tensor);
+                    ++rewrites;
+                }
+            return rewrites;
+        }
+
+    private:
+        // unlike GraphObj::isUnused, a tensor nobody reads is live while the
+        // outputs are inferred
+        static bool isDead(const GraphObj &graph, const Tensor &tensor)
+        {
+            return tensor->getTargets().empty() && !graph.isOutput(tensor);
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(EliminateDeadCode, "eliminate-dead-code", 10, 1);
@@ -0,0 +1,76 @@
+#include "core/graph.h"
+#include "core/kernel.h"
+#include "core/runtime.h"
+#include "core/weight_region.h"
+
+namespace infini
+{
+    /**
+     * @brief Run the ops whose inputs are all weights holding data once, at
+     * optimize time, and keep their outputs as new weights. Weights only hold
+     * data after GraphObj::bindWeights, so the pass does nothing on graphs
+     * optimized before their weights are loaded. The blocks of the weights
+     * the folds drop are released, so the region does not keep both the
+     * inputs and the outputs of a fold; a region shared with other graphs
+     * keeps them, as those may still read them.
+     */
+    class FoldConstants : public GraphPass
+    {
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            auto runtime = graph.getRuntime();
+            auto &registry = KernelRegistry::getInstance();
+            for (auto &op : OpVec(graph.getOperators()))
+            {
+                auto kernelAttrs =
+                    KernelAttrs{runtime->getDevice(), op->getOpType().underlying()};
+                if (!isFoldable(op) || !registry.hasKernel(kernelAttrs))
+                    continue;
+                // new weights go to a new chunk of the region, the data
+                // already bound stays in place
+                for (auto &output : op->getOutputs())
+                    output->setWeight();
+                graph.getWeightRegion()->bind(op->getOutputs());
+
+                auto kernel = registry.getKernel(kernelAttrs);
+                size_t workspaceSize = kernel->getWorkspaceSize(op);
+                void *workspace =
+                    workspaceSize ? runtime->alloc(workspaceSize,
+                                                   Allocator::defaultAlignment)
+                                  : nullptr;
+                runtime->runOp(op, workspace, workspaceSize);
+                if (workspace)
+                    runtime->dealloc(workspace);
+
+                auto inputs = op->getInputs();
+                graph.detachOperator(op);
+                for (auto &input : inputs)
+                    if (graph.isUnused(input) && !input->getSource() &&
+                        graph.getTensor(input->getFuid()))
+                    {
+                        graph.removeTensor(input);
+                        if (!graph.sharesWeightRegion())
+                            graph.getWeightRegion()->release(input);
+                    }
+                ++rewrites;
+            }
+            return rewrites;
+        }
+
+    private:
+        static bool isFoldable(const Operator &op)
+        {
+            if (op->getInputs().empty())
+                return false;
+            for (auto &input : op->getInputs())
+                if (!input->isWeight() || !input->hasData())
+                    return false;
+            return true;
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(FoldConstants, "fold-constants", 50, 1);
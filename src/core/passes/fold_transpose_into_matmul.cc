@@ -0,0 +1,54 @@
+#include "core/graph.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+
+namespace infini
+{
+    /**
+     * @brief Fold a transpose that swaps the last two dims of a matmul input
+     * into the transA / transB attribute of the matmul, unless the same
+     * tensor is also its bias.
+     */
+    class FoldTransposeIntoMatmul : public GraphPass
+    {
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            for (auto &op : OpVec(graph.getOperators()))
+            {
+                if (op->getOpType() != OpType::MatMul)
+                    continue;
+                auto matmul = as<MatmulObj>(op);
+                // flipping one flag can not express a shared transposed input
+                if (matmul->getInputs(0) == matmul->getInputs(1))
+                    continue;
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    auto input = matmul->getInputs(i);
+                    auto source = input->getSource();
+                    if (!source || source->getOpType() != OpType::Transpose ||
+                        !as<TransposeObj>(source)->swapsLastTwoDims())
+                        continue;
+                    // the bias reads the transposed layout, the flags do not
+                    // apply to it
+                    if (input == matmul->getBias())
+                        continue;
+                    if (i == 0)
+                        matmul->setTransA(!matmul->getTransA());
+                    else
+                        matmul->setTransB(!matmul->getTransB());
+                    graph.replaceInput(op, input, source->getInputs(0));
+                    if (graph.isUnused(input))
+                        graph.eraseOperator(source);
+                    ++rewrites;
+                }
+            }
+            return rewrites;
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(FoldTransposeIntoMatmul, "fold-transpose-into-matmul", 200,
+                    1);
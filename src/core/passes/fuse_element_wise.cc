@@ -0,0 +1,145 @@
+#include "core/graph.h"
+#include "operators/fused_element_wise.h"
+#include "operators/unary.h"
+
+namespace infini
+{
+    /**
+     * @brief Merge chains of Add, Sub, Mul, Div, Relu and Clip, and earlier
+     * fused ops, into one FusedElementWiseObj. A producer joins the chain of
+     * its consumer when the consumer is the only reader of its output, so no
+     * intermediate tensor has to be kept.
+     */
+    class FuseElementWise : public GraphPass
+    {
+        // Builds the expression of the ops absorbed into one root. Operands
+        // are step indices, or ~i for leaf i until the leaves are known; the
+        // rhs of unary steps is ignored.
+        struct Builder
+        {
+            const GraphObj &graph;
+            DataType dtype;
+            TensorVec leaves;
+            std::unordered_map<TensorObj *, int> leafIndex;
+            vector<FusedElementWiseStep> steps;
+            OpVec group;
+
+            int visit(const Tensor &tensor)
+            {
+                auto source = tensor->getSource();
+                if (source && isFusible(source) &&
+                    tensor->getTargets().size() == 1 && !graph.isOutput(tensor) &&
+                    tensor->getDType() == dtype)
+                    return emit(source);
+                auto it = leafIndex.find(tensor.get());
+                if (it == leafIndex.end())
+                {
+                    it = leafIndex.emplace(tensor.get(), leaves.size()).first;
+                    leaves.emplace_back(tensor);
+                }
+                return ~it->second;
+            }
+
+            int emit(const Operator &op)
+            {
+                group.emplace_back(op);
+                if (op->getOpType() == OpType::FusedElementWise)
+                {
+                    // inline the steps, renumbering their operands
+                    auto fused = as<FusedElementWiseObj>(op);
+                    vector<int> values;
+                    for (auto &input : fused->getInputs())
+                        values.emplace_back(visit(input));
+                    for (auto step : fused->getSteps())
+                    {
+                        step.lhs = values[step.lhs];
+                        step.rhs = step.rhs < 0 ? -1 : values[step.rhs];
+                        values.emplace_back(addStep(step));
+                    }
+                    return values.back();
+                }
+                FusedElementWiseStep step{op->getOpType(), 0, -1, {}, {}};
+                step.lhs = visit(op->getInputs(0));
+                if (op->numInputs() == 2)
+                    step.rhs = visit(op->getInputs(1));
+                if (op->getOpType() == OpType::Clip)
+                {
+                    auto clip = as<ClipObj>(op);
+                    step.min = clip->getMin();
+                    step.max = clip->getMax();
+                }
+                return addStep(step);
+            }
+
+            int addStep(FusedElementWiseStep step)
+            {
+                steps.emplace_back(step);
+                return steps.size() - 1;
+            }
+
+            vector<FusedElementWiseStep> finish() const
+            {
+                int nLeaves = leaves.size();
+                auto resolve = [&](int v)
+                { return v < 0 ? ~v : nLeaves + v; };
+                auto ret = steps;
+                for (auto &step : ret)
+                {
+                    bool unary = step.type == OpType::Relu ||
+                                 step.type == OpType::Clip;
+                    step.lhs = resolve(step.lhs);
+                    step.rhs = unary ? -1 : resolve(step.rhs);
+                }
+                return ret;
+            }
+        };
+
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            auto ops = graph.getOperators();
+            // consumers first, so each chain is absorbed by its last op
+            for (auto it = ops.rbegin(); it != ops.rend(); ++it)
+            {
+                const auto &root = *it;
+                if (graph.getOperator(root->getGuid()) != root ||
+                    !isFusible(root))
+                    continue;
+                auto dtype = root->getOutput()->getDType();
+                if (!(dtype == DataType::Float32 || dtype == DataType::UInt32))
+                    continue;
+                Builder builder{graph, dtype};
+                builder.emit(root);
+                if (builder.group.size() < 2)
+                    continue;
+                auto fused = make_ref<FusedElementWiseObj>(
+                    nullptr, builder.leaves, root->getOutput(), builder.finish());
+                graph.replaceSubgraph(builder.group, fused);
+                ++rewrites;
+            }
+            return rewrites;
+        }
+
+    private:
+        static bool isFusible(const Operator &op)
+        {
+            switch (op->getOpType().underlying())
+            {
+            case OpType::Add:
+            case OpType::Sub:
+            case OpType::Mul:
+            case OpType::Div:
+            case OpType::Relu:
+            case OpType::Clip:
+            case OpType::FusedElementWise:
+                return true;
+            default:
+                return false;
+            }
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(FuseElementWise, "fuse-element-wise", 300, 2);
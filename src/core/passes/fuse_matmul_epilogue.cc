@@ -0,0 +1,85 @@
+#include "core/graph.h"
+#include "operators/matmul.h"
+#include "operators/unary.h"
+#include "utils/operator_utils.h"
+
+namespace infini
+{
+    /**
+     * @brief Fold an Add of a bias, then a Relu or Clip, that only read the
+     * output of a matmul into the epilogue of the matmul.
+     */
+    class FuseMatmulEpilogue : public GraphPass
+    {
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            for (auto &op : OpVec(graph.getOperators()))
+            {
+                if (op->getOpType() != OpType::MatMul)
+                    continue;
+                auto matmul = as<MatmulObj>(op);
+                while (auto fused = foldNext(graph, matmul))
+                {
+                    matmul = fused;
+                    ++rewrites;
+                }
+            }
+            return rewrites;
+        }
+
+    private:
+        // the matmul with its consumer folded in, or nullptr
+        static Ref<MatmulObj> foldNext(GraphObj &graph,
+                                       const Ref<MatmulObj> &matmul)
+        {
+            auto output = matmul->getOutput();
+            auto targets = output->getTargets();
+            if (targets.size() != 1 || graph.isOutput(output) ||
+                matmul->getAct() != ActType::None)
+                return nullptr;
+            auto next = targets[0];
+            auto bias = matmul->getBias();
+            auto act = ActType::None;
+            std::optional<float> clipMin, clipMax;
+            switch (next->getOpType().underlying())
+            {
+            case OpType::Add:
+            {
+                if (bias)
+                    return nullptr;
+                auto other = next->getInputs(0) == output ? next->getInputs(1)
+                                                          : next->getInputs(0);
+                // the bias must not widen the output
+                const auto &shape = output->getDims();
+                if (other == output ||
+                    infer_broadcast(shape, other->getDims()) != shape ||
+                    !(other->getDType() == output->getDType()))
+                    return nullptr;
+                bias = other;
+                break;
+            }
+            case OpType::Relu:
+                act = ActType::Relu;
+                break;
+            case OpType::Clip:
+                act = ActType::Clip;
+                clipMin = as<ClipObj>(next)->getMin();
+                clipMax = as<ClipObj>(next)->getMax();
+                break;
+            default:
+                return nullptr;
+            }
+            auto fused = make_ref<MatmulObj>(
+                nullptr, matmul->getInputs(0), matmul->getInputs(1),
+                next->getOutput(), matmul->getTransA(), matmul->getTransB(),
+                bias, act, clipMin, clipMax);
+            graph.replaceSubgraph({matmul, next}, fused);
+            return fused;
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(FuseMatmulEpilogue, "fuse-matmul-epilogue", 250, 2);
@@ -0,0 +1,233 @@
+#include "core/graph.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+
+namespace infini
+{
+    /**
+     * @brief Move transposes past the ops that do not care about the layout
+     * (Relu, Clip, Cast and binary element-wise ops) until they meet another
+     * transpose or a matmul, so compose-transpose and
+     * fold-transpose-into-matmul can remove them. A transpose is sunk towards
+     * its readers when the chain below it ends at one of those, otherwise it
+     * is hoisted towards its producers when that cancels it against a
+     * transpose above. Transposes that would only move are left in place.
+     */
+    class SinkTranspose : public GraphPass
+    {
+    public:
+        size_t run(GraphObj &graph) const override
+        {
+            size_t rewrites = 0;
+            for (auto &op : OpVec(graph.getOperators()))
+            {
+                // an earlier rewrite may have moved it already
+                if (op->getOpType() != OpType::Transpose ||
+                    !graph.getOperator(op->getGuid()))
+                    continue;
+                auto transpose = as<TransposeObj>(op);
+                size_t moves = 0;
+                while (auto sunk = sinkOnce(graph, transpose))
+                {
+                    transpose = sunk;
+                    ++moves;
+                }
+                if (moves == 0)
+                    while (auto hoisted = hoistOnce(graph, transpose))
+                    {
+                        transpose = hoisted;
+                        ++moves;
+                    }
+                rewrites += moves;
+            }
+            return rewrites;
+        }
+
+    private:
+        // the op reading `tensor`, if only one op does and it is not a graph
+        // output, so moving the transpose may drop it
+        static Operator singleReader(const GraphObj &graph, const Tensor &tensor)
+        {
+            auto targets = tensor->getTargets();
+            if (targets.empty() || graph.isOutput(tensor))
+                return nullptr;
+            for (auto &target : targets)
+                if (target != targets[0])
+                    return nullptr;
+            return targets[0];
+        }
+
+        static bool isUnaryMovable(const Operator &op)
+        {
+            auto type = op->getOpType();
+            return type == OpType::Relu || type == OpType::Clip ||
+                   type == OpType::Cast;
+        }
+
+        // a tensor broadcast against the output of the transpose reads the
+        // same elements once the transpose moves past the op
+        static bool isPermuteInvariant(const Shape &dims,
+                                       const vector<int> &permute)
+        {
+            int rank = permute.size(), offset = rank - (int)dims.size();
+            if (offset < 0)
+                return false;
+            for (size_t i = 0; i < dims.size(); ++i)
+                if (dims[i] != 1 && permute[offset + i] != offset + (int)i)
+                    return false;
+            return true;
+        }
+
+        /**
+         * @brief The inputs of `op` once the transpose writing `from` moves
+         * after it, reading `to` instead; std::nullopt if `op` depends on the
+         * layout. Another input transposed the same way is read untransposed.
+         */
+        static optional<TensorVec> sunkInputs(const Operator &op,
+                                              const Tensor &from,
+                                              const Tensor &to,
+                                              const vector<int> &permute)
+        {
+            if (isUnaryMovable(op))
+                return TensorVec{to};
+            auto type = op->getOpType();
+            if (type != OpType::Add && type != OpType::Sub &&
+                type != OpType::Mul && type != OpType::Div)
+                return std::nullopt;
+            // the other input must not widen the output
+            if (op->getOutput()->getDims() != from->getDims())
+                return std::nullopt;
+            TensorVec inputs;
+            for (auto &input : op->getInputs())
+            {
+                auto source = input->getSource();
+                if (input == from)
+                    inputs.emplace_back(to);
+                else if (source && source->getOpType() == OpType::Transpose &&
+                         as<TransposeObj>(source)->getPermute() == permute)
+                    inputs.emplace_back(source->getInputs(0));
+                else if (isPermuteInvariant(input->getDims(), permute))
+                    inputs.emplace_back(input);
+                else
+                    return std::nullopt;
+            }
+            return inputs;
+        }
+
+        // whether the chain of single readers below `tensor` ends at an op
+        // that removes the transpose
+        static bool reachesSink(const GraphObj &graph, Tensor tensor,
+                                const Ref<TransposeObj> &transpose)
+        {
+            const auto &permute = transpose->getPermute();
+            while (auto next = singleReader(graph, tensor))
+            {
+                if (next->getOpType() == OpType::Transpose)
+                    return true;
+                if (next->getOpType() == OpType::MatMul)
+                    return tensor != as<MatmulObj>(next)->getBias() &&
+                           next->getInputs(0) != next->getInputs(1) &&
+                           transpose->swapsLastTwoDims();
+                if (!sunkInputs(next, tensor, tensor, permute))
+                    return false;
+                tensor = next->getOutput();
+            }
+            return false;
+        }
+
+        // whether the chain of unary ops above `tensor` starts at a transpose
+        // that cancels `transpose`
+        static bool reachesSource(const GraphObj &graph, Tensor tensor,
+                                  const Ref<TransposeObj> &transpose)
+        {
+            Operator reader = transpose;
+            while (auto source = tensor->getSource())
+            {
+                // the transpose above may have other readers, it stays
+                if (source->getOpType() == OpType::Transpose)
+                {
+                    auto p1 = as<TransposeObj>(source)->getPermute();
+                    auto p2 = transpose->getPermute();
+                    for (size_t i = 0; i < p2.size(); ++i)
+                        if (p1[p2[i]] != (int)i)
+                            return false;
+                    return true;
+                }
+                if (!isUnaryMovable(source) ||
+                    singleReader(graph, tensor) != reader)
+                    return false;
+                reader = source;
+                tensor = source->getInputs(0);
+            }
+            return false;
+        }
+
+        // the transpose moved after its reader, or nullptr
+        static Ref<TransposeObj> sinkOnce(GraphObj &graph,
+                                          const Ref<TransposeObj> &transpose)
+        {
+            auto input = transpose->getInputs(0);
+            auto output = transpose->getOutput();
+            const auto permute = transpose->getPermute();
+            auto next = singleReader(graph, output);
+            if (!next || !reachesSink(graph, output, transpose))
+                return nullptr;
+            auto inputs = sunkInputs(next, output, input, permute);
+            if (!inputs)
+                return nullptr;
+
+            // `next` runs on the untransposed layout and the transpose
+            // writes its old output
+            auto nextOutput = next->getOutput();
+            auto moved = graph.addTensor(input->getDims(), nextOutput->getDType());
+            auto movedNext = next->clone(*inputs, {moved});
+            OpVec others;
+            for (auto &other : next->getInputs())
+                if (other != output && other->getSource() &&
+                    other->getSource()->getOpType() == OpType::Transpose &&
+                    std::find(inputs->begin(), inputs->end(), other) ==
+                        inputs->end())
+                    others.emplace_back(other->getSource());
+            graph.detachOperator(next);
+            graph.eraseOperator(transpose);
+            for (auto &other : others)
+                if (graph.getOperator(other->getGuid()) &&
+                    graph.isUnused(other->getOutput()))
+                    graph.eraseOperator(other);
+            graph.addOperator(movedNext);
+            return graph.addOpWithOutputs<TransposeObj>(moved, nextOutput,
+                                                        permute);
+        }
+
+        // the transpose moved before the unary op it reads, or nullptr
+        static Ref<TransposeObj> hoistOnce(GraphObj &graph,
+                                           const Ref<TransposeObj> &transpose)
+        {
+            auto input = transpose->getInputs(0);
+            auto prev = input->getSource();
+            if (!prev || !isUnaryMovable(prev) ||
+                !reachesSource(graph, input, transpose))
+                return nullptr;
+
+            // the transpose reads the input of `prev`, which writes the old
+            // output of the transpose
+            const auto permute = transpose->getPermute();
+            auto prevInput = prev->getInputs(0);
+            Shape dims(permute.size());
+            for (size_t i = 0; i < permute.size(); ++i)
+                dims[i] = prevInput->getDims()[permute[i]];
+            auto moved = graph.addTensor(dims, prevInput->getDType());
+            auto output = transpose->getOutput();
+            auto movedPrev = prev->clone({moved}, {output});
+            graph.detachOperator(transpose);
+            graph.eraseOperator(prev);
+            auto hoisted =
+                graph.addOpWithOutputs<TransposeObj>(prevInput, moved, permute);
+            graph.addOperator(movedPrev);
+            return hoisted;
+        }
+    };
+
+} // namespace infini
+
+REGISTER_GRAPH_PASS(SinkTranspose, "sink-transpose", 150, 1);
@@ -1,16 +1,38 @@
 #include "core/runtime.h"
 #include "core/blob.h"
+#include "core/execution_context.h"
 #include "core/kernel.h"
 #include "core/graph.h"
 #include "core/kernel.h"
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <memory>
+#include <sys/mman.h>
+#include <unistd.h>
 namespace infini
 {
+    // Workspace of the graph being run on this thread, so that concurrent runs
+    // of different graphs do not share scratch memory.
+    static thread_local void *currentWorkspace = nullptr;
+    static thread_local size_t currentWorkspaceSize = 0;
+
+    void *RuntimeObj::getWorkspace(size_t size) const
+    {
+        IT_ASSERT(size <= currentWorkspaceSize,
+                  "Workspace of " + std::to_string(size) +
+                      " bytes was not reserved, see Kernel::getWorkspaceSize");
+        return currentWorkspace;
+    }
+
     void NativeCpuRuntimeObj::run(const Graph &graph) const
     {
         const auto &kernelRegistry = KernelRegistry::getInstance();
+        currentWorkspace = graph->getWorkspace();
+        currentWorkspaceSize = graph->getWorkspaceSize();
 
         for (auto &op : graph->getOperators())
         {
@@ -20,17 +42,131 @@ namespace infini
         }
     }
 
+    void NativeCpuRuntimeObj::run(const ExecutionContext &context) const
+    {
+        const auto &plan = context->getPlan();
+        currentWorkspace = context->getWorkspace();
+        currentWorkspaceSize = plan->getWorkspaceSize();
+
+        const auto &ops = context->getOperators();
+        for (size_t i = 0; i < ops.size(); ++i)
+            plan->getKernel(i)->compute(ops[i], this);
+    }
+
+    void NativeCpuRuntimeObj::runOp(const Operator &op, void *workspace,
+                                    size_t workspaceSize) const
+    {
+        auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
+        Kernel *kernel = KernelRegistry::getInstance().getKernel(kernelAttrs);
+        auto savedWorkspace = currentWorkspace;
+        auto savedWorkspaceSize = currentWorkspaceSize;
+        currentWorkspace = workspace;
+        currentWorkspaceSize = workspaceSize;
+        kernel->compute(op, this);
+        currentWorkspace = savedWorkspace;
+        currentWorkspaceSize = savedWorkspaceSize;
+    }
+
     string NativeCpuRuntimeObj::toString() const { return "CPU Runtime"; }
 
     void NativeCpuRuntimeObj::dealloc(void *ptr)
     {
+        {
+            std::lock_guard<std::mutex> lock(mappingsMutex);
+            auto it = mappings.find(ptr);
+            if (it != mappings.end())
+            {
+                munmap(ptr, it->second);
+                mappings.erase(it);
+                return;
+            }
+        }
         return free(ptr);
     }
 
-    void *NativeCpuRuntimeObj::alloc(size_t size)
+    void *NativeCpuRuntimeObj::alloc(size_t size, size_t alignment)
     {
-        return calloc((size + sizeof(uint64_t) - 1) / sizeof(uint64_t),
-                      sizeof(uint64_t));
+        if (allocConfig.mode == CpuAllocMode::Mmap)
+            return mmapAlloc(size, alignment);
+        alignment = std::max(alignment, sizeof(void *));
+        // aligned_alloc requires the size to be a multiple of the alignment
+        size = std::max((size + alignment - 1) / alignment * alignment, alignment);
+        void *ptr = std::aligned_alloc(alignment, size);
+        IT_ASSERT(ptr != nullptr, "Out of memory allocating " +
+                                      std::to_string(size) + " bytes");
+        // zero-filled like the former calloc
+        return memset(ptr, 0, size);
+    }
+
+    size_t NativeCpuRuntimeObj::getHugePageSize() const
+    {
+        if (allocConfig.hugePages == HugePageMode::None)
+            return 0;
+        if (allocConfig.hugePageSize)
+            return allocConfig.hugePageSize;
+        // read once, the sizes do not change while the process runs
+        static const size_t transparentSize = []() -> size_t
+        {
+            size_t size = 0;
+            std::ifstream("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size") >>
+                size;
+            return size;
+        }();
+        static const size_t explicitSize = []() -> size_t
+        {
+            std::ifstream meminfo("/proc/meminfo");
+            string key;
+            size_t kiB = 0;
+            while (meminfo >> key)
+                if (key == "Hugepagesize:" && meminfo >> kiB)
+                    return kiB << 10;
+            return 0;
+        }();
+        size_t size = allocConfig.hugePages == HugePageMode::Transparent &&
+                              transparentSize
+                          ? transparentSize
+                          : explicitSize;
+        return size ? size : 2 << 20;
+    }
+
+    void *NativeCpuRuntimeObj::mmapAlloc(size_t size, size_t alignment)
+    {
+        const size_t pageSize = sysconf(_SC_PAGESIZE),
+                     hugePageSize = getHugePageSize();
+        IT_ASSERT(alignment <= pageSize, "mmap can not align to " +
+                                             std::to_string(alignment));
+        IT_ASSERT((hugePageSize & (hugePageSize - 1)) == 0 &&
+                      (hugePageSize == 0 || hugePageSize >= pageSize),
+                  "Huge page size " + std::to_string(hugePageSize) +
+                      " is not a power of two of at least a page");
+        size_t granule = hugePageSize ? hugePageSize : pageSize;
+        size = std::max((size + granule - 1) / granule * granule, granule);
+
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        if (allocConfig.populate)
+            flags |= MAP_POPULATE;
+        void *ptr = MAP_FAILED;
+        if (allocConfig.hugePages == HugePageMode::Explicit)
+        {
+            int hugeFlags = MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+            // pick the pool of this size when the host has several
+            hugeFlags |= __builtin_ctzll(hugePageSize) << MAP_HUGE_SHIFT;
+#endif
+            ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | hugeFlags,
+                       -1, 0);
+        }
+        if (ptr == MAP_FAILED)
+            ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        IT_ASSERT(ptr != MAP_FAILED, "mmap of " + std::to_string(size) +
+                                         " bytes failed: " + strerror(errno));
+        // best effort, THP may be disabled system-wide
+        if (allocConfig.hugePages == HugePageMode::Transparent)
+            madvise(ptr, size, MADV_HUGEPAGE);
+
+        std::lock_guard<std::mutex> lock(mappingsMutex);
+        mappings[ptr] = size;
+        return ptr;
     }
 
 } // namespace infini
@@ -2,6 +2,7 @@
 #include "core/blob.h"
 #include "core/operator.h"
 #include "core/runtime.h"
+#include <algorithm>
 #include <cstring>
 #include <numeric>
 
@@ -41,6 +42,23 @@ void TensorObj::setShape(Shape shape_) {
     _size = size;
 }
 
+void TensorObj::setSymbolicDim(int dim, const string &name) {
+    IT_ASSERT(dim >= 0 && dim < (int)shape.size());
+    auto names = symbols;
+    names.resize(shape.size());
+    names[dim] = name;
+    setSymbolicDims(std::move(names));
+}
+
+void TensorObj::setSymbolicDims(vector<string> names) {
+    IT_ASSERT(names.empty() || names.size() == shape.size());
+    // all fixed is stored as no names, so equal labels compare equal
+    if (std::all_of(names.begin(), names.end(),
+                    [](const string &name) { return name.empty(); }))
+        names.clear();
+    symbols = std::move(names);
+}
+
 void TensorObj::printData() const {
     IT_ASSERT(data != nullptr);
     if (!runtime->isCpu())
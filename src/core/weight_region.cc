@@ -0,0 +1,134 @@
+#include "core/weight_region.h"
+#include <algorithm>
+
+namespace infini
+{
+    void WeightRegionObj::reserve(const TensorVec &weights)
+    {
+        for (auto &weight : weights)
+        {
+            if (contains(weight))
+            {
+                // a pinned block released meanwhile is taken back
+                pendingReleases.erase(weight->getFuid());
+                continue;
+            }
+            // a hole left by a released weight takes it without moving the
+            // data bound in that chunk
+            size_t size = std::max<size_t>(
+                (weight->getBytes() + alignment - 1) / alignment * alignment,
+                alignment);
+            size_t chunk = 0;
+            while (chunk < materializedChunks &&
+                   chunks[chunk].getLargestFreeBlock() < size)
+                ++chunk;
+            if (chunk == chunks.size())
+            {
+                chunks.emplace_back(runtime, alignment);
+                chunkWeights.emplace_back(0);
+            }
+            offsets[weight->getFuid()] = {chunk,
+                                          chunks[chunk].alloc(weight->getBytes())};
+            ++chunkWeights[chunk];
+        }
+    }
+
+    void WeightRegionObj::bind(const TensorVec &weights)
+    {
+        if (weights.empty())
+            return;
+        reserve(weights);
+        materializedChunks = chunks.size();
+        for (auto &weight : weights)
+        {
+            if (auto it = externalBlobs.find(weight->getFuid());
+                it != externalBlobs.end())
+            {
+                weight->setDataBlob(it->second);
+                continue;
+            }
+            auto [chunk, offset] = offsets.at(weight->getFuid());
+            char *basePtr = reinterpret_cast<char *>(chunks[chunk].getPtr());
+            weight->setDataBlob(make_ref<BlobObj>(weight->getRuntime(),
+                                                  basePtr + offset, alignment));
+        }
+    }
+
+    void WeightRegionObj::bindExternal(const Tensor &weight, void *ptr,
+                                       size_t alignment,
+                                       const std::shared_ptr<void> &owner)
+    {
+        IT_ASSERT(!contains(weight), "Weight already bound");
+        auto blob = make_ref<BlobObj>(weight->getRuntime(), ptr, alignment);
+        externalBlobs.emplace(weight->getFuid(), blob);
+        externalBytes += weight->getBytes();
+        if (owners.empty() || owners.back() != owner)
+            owners.emplace_back(owner);
+        weight->setDataBlob(blob);
+    }
+
+    void WeightRegionObj::release(const Tensor &weight)
+    {
+        if (auto it = externalBlobs.find(weight->getFuid());
+            it != externalBlobs.end())
+        {
+            externalBlobs.erase(it);
+            externalBytes -= weight->getBytes();
+            return;
+        }
+        IT_ASSERT(offsets.count(weight->getFuid()), "Weight not in the region");
+        if (pins.count(weight->getFuid()))
+            pendingReleases[weight->getFuid()] = weight->getBytes();
+        else
+            freeBlock(weight->getFuid(), weight->getBytes());
+    }
+
+    void WeightRegionObj::freeBlock(UidBaseType fuid, size_t bytes)
+    {
+        auto it = offsets.find(fuid);
+        auto [chunk, offset] = it->second;
+        offsets.erase(it);
+        chunks[chunk].free(offset, bytes);
+        if (--chunkWeights[chunk] == 0)
+            chunks[chunk].release();
+    }
+
+    void WeightRegionObj::pin(const TensorVec &weights)
+    {
+        for (auto &weight : weights)
+            if (offsets.count(weight->getFuid()))
+                ++pins[weight->getFuid()];
+    }
+
+    void WeightRegionObj::unpin(const TensorVec &weights)
+    {
+        for (auto &weight : weights)
+        {
+            auto it = pins.find(weight->getFuid());
+            if (it == pins.end() || --it->second > 0)
+                continue;
+            pins.erase(it);
+            if (auto released = pendingReleases.find(weight->getFuid());
+                released != pendingReleases.end())
+            {
+                freeBlock(released->first, released->second);
+                pendingReleases.erase(released);
+            }
+        }
+    }
+
+    size_t WeightRegionObj::getSize() const
+    {
+        size_t size = externalBytes;
+        for (auto &chunk : chunks)
+            size += chunk.getPeak();
+        return size;
+    }
+
+    bool WeightRegionObj::contains(const Tensor &weight) const
+    {
+        return offsets.find(weight->getFuid()) != offsets.end() ||
+               externalBlobs.count(weight->getFuid()) > 0;
+    }
+
+} // namespace infini
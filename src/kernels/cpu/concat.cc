@@ -7,31 +7,31 @@ class NaiveConcat : public CpuKernelWithoutConfig {
     template <typename T>
     void doCompute(const Operator &_op, const RuntimeObj *context) const {
         auto op = as<ConcatObj>(_op);
-        auto inputs = op->getInputs(), outputs = op->getOutputs();
+        const auto &inputs = op->getInputs();
         auto dim = op->getDim();
-        auto output = outputs[0];
-        std::vector<Shape> iDims;
-        for (auto input : inputs)
-            iDims.emplace_back(input->getDims());
+        const auto &output = op->getOutput();
         const auto &outDim = output->getDims();
+        if (output->size() == 0)
+            return;
         size_t blockOffsetInner = 1;
         for (size_t i = outDim.size() - 1; i > (size_t)dim; --i)
             blockOffsetInner *= outDim[i];
         size_t blockOffset = outDim[dim] * blockOffsetInner;
+        // the inputs match the output outside the concatenated dim, so they
+        // share the number of outer blocks
+        size_t outerBlocks = output->size() / blockOffset;
+        size_t dimOffset = 0;
         for (size_t i = 0; i < inputs.size(); ++i) {
-            auto input = inputs[i];
-            auto dimOffset = 0;
-            auto iDim = iDims[i];
-            for (size_t j = 0; j < i; ++j)
-                dimOffset += iDims[j][dim];
-            size_t localBlockOffset = 1;
-            for (size_t i = iDim.size() - 1;
-                 i >= (size_t)dim && i != (size_t)-1; --i)
-                localBlockOffset *= iDim[i];
+            const auto &input = inputs[i];
+            size_t localBlockOffset = input->size() / outerBlocks;
             auto innerOffset = blockOffsetInner * dimOffset;
+            dimOffset += localBlockOffset / blockOffsetInner;
             auto inSize = input->size();
             auto inPtr = input->getRawDataPtr<T *>(),
                  outPtr = output->getRawDataPtr<T *>();
+            // the memory plan may let the producer write the slice in place
+            if (outerBlocks == 1 && inPtr == outPtr + innerOffset)
+                continue;
 #pragma omp parallel for
             for (size_t iOffset = 0; iOffset < inSize; ++iOffset) {
                 auto oOffset = iOffset % localBlockOffset + innerOffset +
@@ -38,29 +38,16 @@ namespace infini
             T *inptr1 = op->getInputs(1)->getRawDataPtr<T *>();
             T *outptr = op->getOutput()->getRawDataPtr<T *>();
 
-            auto shapeA = op->getInputs(0)->getDims();
-            auto shapeB = op->getInputs(1)->getDims();
-            auto shapeC = op->getOutput()->getDims();
+            // workspace: the output dims, then the strides of both inputs
+            // with 0 for broadcast dims
             auto rank = op->getOutput()->getRank();
-            Shape a(rank, 1);
-            Shape b(rank, 1);
-            std::copy(shapeA.begin(), shapeA.end(),
-                      a.begin() + (rank - shapeA.size()));
-            std::copy(shapeB.begin(), shapeB.end(),
-                      b.begin() + (rank - shapeB.size()));
-            auto getStride = [&](const Shape &shape)
-            {
-                int p = 1;
-                Shape stride(rank);
-                for (auto i = rank; i > 0; --i)
-                {
-                    stride[i - 1] = p;
-                    p = p * shape[i - 1];
-                }
-                return stride;
-            };
-            Shape strideA = getStride(a);
-            Shape strideB = getStride(b);
+            auto dims = reinterpret_cast<size_t *>(
+                context->getWorkspace(getWorkspaceSize(_op)));
+            auto strideA = dims + rank, strideB = strideA + rank;
+            const auto &shapeC = op->getOutput()->getDims();
+            std::copy(shapeC.begin(), shapeC.end(), dims);
+            get_broadcast_strides(op->getInputs(0)->getDims(), rank, strideA);
+            get_broadcast_strides(op->getInputs(1)->getDims(), rank, strideB);
 
             auto n = op->getOutput()->size();
             T (*_doCompute)
@@ -85,13 +72,27 @@ namespace infini
 
             for (size_t i = 0; i < n; ++i)
             {
-                auto shapeIndexC = locate_index(i, shapeC);
-                auto indexA = delocate_index(shapeIndexC, a, strideA);
-                auto indexB = delocate_index(shapeIndexC, b, strideB);
+                size_t rest = i, indexA = 0, indexB = 0;
+                for (size_t j = rank; j-- > 0;)
+                {
+                    auto pos = rest % dims[j];
+                    rest /= dims[j];
+                    indexA += pos * strideA[j];
+                    indexB += pos * strideB[j];
+                }
                 outptr[i] = _doCompute(inptr0[indexA], inptr1[indexB]);
             }
         }
 
+        size_t getWorkspaceSize(const Operator &op) const override
+        {
+            return 3 * op->getOutput()->getRank() * sizeof(size_t);
+        }
+
+        // Only an input with the output's shape may be aliased, and such an
+        // input is read at the same offset that is written.
+        bool isInPlaceSafe() const override { return true; }
+
         void compute(const Operator &_op,
                      const RuntimeObj *context) const override
         {
@@ -0,0 +1,125 @@
+#include "operators/fused_element_wise.h"
+#include "core/kernel.h"
+#include "utils/operator_utils.h"
+
+namespace infini
+{
+    class NativeFusedElementWise : public CpuKernelWithoutConfig
+    {
+        template <typename T>
+        static T apply(const FusedElementWiseStep &step, T lhs, T rhs)
+        {
+            switch (step.type.underlying())
+            {
+            case OpType::Add:
+                return lhs + rhs;
+            case OpType::Sub:
+                return lhs - rhs;
+            case OpType::Mul:
+                return lhs * rhs;
+            case OpType::Div:
+                return (T)(lhs / rhs);
+            case OpType::Relu:
+                return std::max(T(0), lhs);
+            case OpType::Clip:
+                return (step.min && lhs < *step.min)   ? *step.min
+                       : (step.max && lhs > *step.max) ? *step.max
+                                                       : lhs;
+            default:
+                IT_TODO_HALT();
+            }
+        }
+
+        template <typename T>
+        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        {
+            auto op = as<FusedElementWiseObj>(_op);
+            const auto &steps = op->getSteps();
+            size_t nInputs = op->numInputs(), nSteps = steps.size();
+            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+
+            // workspace: the output dims, the position of the current element,
+            // the strides of every input with 0 for broadcast dims, the input
+            // pointers, then one slot per value of the expression
+            auto rank = op->getOutput()->getRank();
+            auto dims = reinterpret_cast<size_t *>(
+                context->getWorkspace(getWorkspaceSize(_op)));
+            auto pos = dims + rank, strides = pos + rank;
+            auto inptrs = reinterpret_cast<T **>(strides + nInputs * rank);
+            auto values = reinterpret_cast<T *>(inptrs + nInputs);
+            const auto &shape = op->getOutput()->getDims();
+            std::copy(shape.begin(), shape.end(), dims);
+            for (size_t k = 0; k < nInputs; ++k)
+            {
+                const auto &input = op->getInputs(k);
+                get_broadcast_strides(input->getDims(), rank,
+                                      strides + k * rank);
+                inptrs[k] = input->getRawDataPtr<T *>();
+            }
+
+            auto n = op->getOutput()->size();
+            for (size_t i = 0; i < n; ++i)
+            {
+                size_t rest = i;
+                for (size_t j = rank; j-- > 0;)
+                {
+                    pos[j] = rest % dims[j];
+                    rest /= dims[j];
+                }
+                for (size_t k = 0; k < nInputs; ++k)
+                {
+                    size_t index = 0;
+                    for (size_t j = 0; j < rank; ++j)
+                        index += pos[j] * strides[k * rank + j];
+                    values[k] = inptrs[k][index];
+                }
+                for (size_t s = 0; s < nSteps; ++s)
+                {
+                    const auto &step = steps[s];
+                    values[nInputs + s] = apply<T>(
+                        step, values[step.lhs],
+                        step.rhs < 0 ? T(0) : values[step.rhs]);
+                }
+                outptr[i] = values[nInputs + nSteps - 1];
+            }
+        }
+
+        size_t getWorkspaceSize(const Operator &_op) const override
+        {
+            auto op = as<FusedElementWiseObj>(_op);
+            size_t nInputs = op->numInputs();
+            size_t rank = op->getOutput()->getRank();
+            return (2 + nInputs) * rank * sizeof(size_t) +
+                   nInputs * sizeof(void *) +
+                   (nInputs + op->getSteps().size()) *
+                       op->getDType().getSize();
+        }
+
+        // Every value of an element is computed before the element is
+        // written, and an aliased input has the output's shape, so it is read
+        // at the offset being written.
+        bool isInPlaceSafe() const override { return true; }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+#define CASE(N) \
+    case N:     \
+        doCompute<DT<N>::t>(_op, context)
+
+            int dataTypeIdx = _op->getDType().getIndex();
+            switch (dataTypeIdx)
+            {
+                CASE(1); // DataType::Float32
+                break;
+                CASE(12); // DataType::UInt32
+                break;
+            default:
+                IT_TODO_HALT();
+            }
+        }
+    };
+
+    REGISTER_KERNEL(Device::CPU, OpType::FusedElementWise,
+                    NativeFusedElementWise, "fusedElementWiseNaive_CPU");
+}; // namespace infini
@@ -0,0 +1,137 @@
+#include "operators/matmul.h"
+#include "core/kernel.h"
+#include "utils/operator_utils.h"
+
+namespace infini
+{
+    class NativeMatmul : public CpuKernelWithoutConfig
+    {
+        // rows, columns and depth of a tile: the C tile stays in L1 while
+        // the depth loop accumulates into it and the epilogue runs over it
+        static constexpr size_t tileM = 32, tileN = 128, tileK = 128;
+
+        template <typename T>
+        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        {
+            auto op = as<MatmulObj>(_op);
+            T *aptr = op->getInputs(0)->getRawDataPtr<T *>();
+            T *bptr = op->getInputs(1)->getRawDataPtr<T *>();
+            T *cptr = op->getOutput()->getRawDataPtr<T *>();
+            auto bias = op->getBias();
+            T *biasptr = bias ? bias->getRawDataPtr<T *>() : nullptr;
+            const size_t M = op->getM(), N = op->getN(), K = op->getK();
+            const bool transA = op->getTransA(), transB = op->getTransB();
+            const auto act = op->getAct();
+            const auto clipMin = op->getClipMin(), clipMax = op->getClipMax();
+
+            // workspace: the output dims, then the strides of A, B and the
+            // bias over the output rank with 0 for broadcast dims
+            auto rank = op->getOutput()->getRank();
+            auto dims = reinterpret_cast<size_t *>(
+                context->getWorkspace(getWorkspaceSize(_op)));
+            auto strideA = dims + rank, strideB = strideA + rank,
+                 strideBias = strideB + rank;
+            const auto &shapeC = op->getOutput()->getDims();
+            std::copy(shapeC.begin(), shapeC.end(), dims);
+            get_broadcast_strides(op->getInputs(0)->getDims(), rank, strideA);
+            get_broadcast_strides(op->getInputs(1)->getDims(), rank, strideB);
+            if (bias)
+                get_broadcast_strides(bias->getDims(), rank, strideBias);
+            const size_t biasM = bias ? strideBias[rank - 2] : 0,
+                         biasN = bias ? strideBias[rank - 1] : 0;
+
+            if (M * N == 0)
+                return;
+            size_t nBatch = op->getOutput()->size() / (M * N);
+            for (size_t batch = 0; batch < nBatch; ++batch)
+            {
+                size_t rest = batch, offA = 0, offB = 0, offBias = 0;
+                for (size_t j = rank - 2; j-- > 0;)
+                {
+                    auto pos = rest % dims[j];
+                    rest /= dims[j];
+                    offA += pos * strideA[j];
+                    offB += pos * strideB[j];
+                    offBias += pos * (bias ? strideBias[j] : 0);
+                }
+                const T *a = aptr + offA, *b = bptr + offB;
+                T *c = cptr + batch * M * N;
+                for (size_t i0 = 0; i0 < M; i0 += tileM)
+                {
+                    size_t i1 = std::min(i0 + tileM, M);
+                    for (size_t j0 = 0; j0 < N; j0 += tileN)
+                    {
+                        size_t j1 = std::min(j0 + tileN, N);
+                        for (size_t i = i0; i < i1; ++i)
+                            std::fill(c + i * N + j0, c + i * N + j1, T(0));
+                        for (size_t p0 = 0; p0 < K; p0 += tileK)
+                        {
+                            size_t p1 = std::min(p0 + tileK, K);
+                            for (size_t i = i0; i < i1; ++i)
+                            {
+                                T *crow = c + i * N;
+                                for (size_t p = p0; p < p1; ++p)
+                                {
+                                    T av = transA ? a[p * M + i] : a[i * K + p];
+                                    if (transB)
+                                        for (size_t j = j0; j < j1; ++j)
+                                            crow[j] += av * b[j * K + p];
+                                    else
+                                        for (size_t j = j0; j < j1; ++j)
+                                            crow[j] += av * b[p * N + j];
+                                }
+                            }
+                        }
+                        if (!bias && act == ActType::None)
+                            continue;
+                        // epilogue while the tile is still in cache
+                        for (size_t i = i0; i < i1; ++i)
+                        {
+                            T *crow = c + i * N;
+                            for (size_t j = j0; j < j1; ++j)
+                            {
+                                T val = crow[j];
+                                if (bias)
+                                    val += biasptr[offBias + i * biasM +
+                                                   j * biasN];
+                                if (act == ActType::Relu)
+                                    val = std::max(T(0), val);
+                                else if (act == ActType::Clip)
+                                    val = (clipMin && val < *clipMin)   ? *clipMin
+                                          : (clipMax && val > *clipMax) ? *clipMax
+                                                                        : val;
+                                crow[j] = val;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        size_t getWorkspaceSize(const Operator &op) const override
+        {
+            return 4 * op->getOutput()->getRank() * sizeof(size_t);
+        }
+
+        void compute(const Operator &_op,
+                     const RuntimeObj *context) const override
+        {
+#define CASE(N) \
+    case N:     \
+        doCompute<DT<N>::t>(_op, context)
+
+            int dataTypeIdx = _op->getDType().getIndex();
+            switch (dataTypeIdx)
+            {
+                CASE(1); // DataType::Float32
+                break;
+                CASE(12); // DataType::UInt32
+                break;
+            default:
+                IT_TODO_HALT();
+            }
+        }
+    };
+
+    REGISTER_KERNEL(Device::CPU, OpType::MatMul, NativeMatmul, "matmulNaive_CPU");
+}; // namespace infini
@@ -3,50 +3,59 @@
 
 namespace infini {
 
-inline Shape idx2Pos(const Shape &shape, size_t idx) {
-    Shape pos = Shape(shape.size(), 0);
-    auto rest = idx, curDimId = shape.size() - 1;
-    while (rest > 0) {
-        pos[curDimId] = rest % shape[curDimId];
-        rest /= shape[curDimId];
-        curDimId--;
-    }
-    return pos;
-}
-
 class NaiveTranspose : public CpuKernelWithoutConfig {
     template <typename T>
     void doCompute(const Operator &_op, const RuntimeObj *context) const {
         auto op = as<TransposeObj>(_op);
-        auto inputs = op->getInputs(), outputs = op->getOutputs();
+        const auto &inputs = op->getInputs(), &outputs = op->getOutputs();
         const auto &inDim = inputs[0]->getDims();
         const auto &perm = op->getPermute();
+        size_t rank = perm.size();
+
+        // workspace: the input dims, then the output stride of each input dim
+        auto dims = reinterpret_cast<size_t *>(
+            context->getWorkspace(getWorkspaceSize(_op)));
+        auto strides = dims + rank;
+        for (size_t j = rank, stride = 1; j-- > 0;) {
+            dims[j] = inDim[j];
+            strides[perm[j]] = stride;
+            stride *= inDim[perm[j]];
+        }
 
         size_t inSize = inputs[0]->size();
         auto inPtr = inputs[0]->getRawDataPtr<T *>(),
              outPtr = outputs[0]->getRawDataPtr<T *>();
         // #pragma omp parallel for
         for (size_t inIdx = 0; inIdx < inSize; ++inIdx) {
-            auto posInput = idx2Pos(inDim, inIdx);
-            int outIdx = 0;
-            for (size_t j = 0, jEnd = perm.size(); j < jEnd; ++j) {
-                outIdx = outIdx * inDim[perm[j]] + posInput[perm[j]];
+            size_t rest = inIdx, outIdx = 0;
+            for (size_t j = rank; j-- > 0;) {
+                outIdx += rest % dims[j] * strides[j];
+                rest /= dims[j];
             }
             outPtr[outIdx] = inPtr[inIdx];
         }
     }
 
+    size_t getWorkspaceSize(const Operator &op) const override {
+        return 2 * op->getInputs(0)->getRank() * sizeof(size_t);
+    }
+
     void compute(const Operator &_op,
                  const RuntimeObj *context) const override {
-#define CASE(N)                                                                \
-    case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
-
-        int dataTypeIdx = _op->getDType().getIndex();
-        switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
+        // a transpose only moves elements, so dispatch on their size; the
+        // transpose-sinking pass may move it past a Cast to another type
+        switch (_op->getDType().getSize()) {
+        case 1:
+            doCompute<uint8_t>(_op, context);
+            break;
+        case 2:
+            doCompute<uint16_t>(_op, context);
+            break;
+        case 4:
+            doCompute<uint32_t>(_op, context);
             break;
-            CASE(12); // DataType::UInt32
+        case 8:
+            doCompute<uint64_t>(_op, context);
             break;
         default:
             IT_TODO_HALT();
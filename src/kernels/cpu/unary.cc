@@ -18,7 +18,6 @@ namespace infini
             T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
             T *outptr = op->getOutput()->getRawDataPtr<T *>();
 
-            auto outDim = op->getOutput()->getDims();
             auto n = op->getOutput()->size();
 
             T (*_doCompute)
@@ -38,6 +37,8 @@ namespace infini
             }
         }
 
+        bool isInPlaceSafe() const override { return true; }
+
         void compute(const Operator &_op,
                      const RuntimeObj *context) const override
         {
@@ -79,6 +80,8 @@ namespace infini
             }
         }
 
+        bool isInPlaceSafe() const override { return true; }
+
         void compute(const Operator &_op,
                      const RuntimeObj *context) const override
         {
@@ -36,6 +36,34 @@ optional<vector<Shape>> ConcatObj::inferShape(const TensorVec &inputs) {
     return {{res}};
 }
 
+vector<vector<string>>
+ConcatObj::inferSymbols(const TensorVec &inputs) const {
+    auto rank = inputs[0]->getRank();
+    vector<string> res(rank);
+    bool symbolic = false;
+    for (auto input : inputs)
+        symbolic |= !input->getSymbolicDim(dim).empty();
+    for (size_t i = 0; i < rank; i++) {
+        if (i != size_t(dim)) {
+            // the inputs agree on the other dims, any of them names it
+            for (auto input : inputs)
+                if (res[i].empty())
+                    res[i] = input->getSymbolicDim(i);
+            continue;
+        }
+        // the sum of the parts, fixed only if all of them are
+        if (!symbolic)
+            continue;
+        for (auto input : inputs) {
+            auto name = input->getSymbolicDim(i);
+            if (!res[i].empty())
+                res[i] += "+";
+            res[i] += name.empty() ? std::to_string(input->getDims()[i]) : name;
+        }
+    }
+    return {res};
+}
+
 std::string ConcatObj::toString() const {
     std::ostringstream os;
     os << "Concat[" << getGuid() << "]";
@@ -17,6 +17,14 @@ namespace infini
         return {{res}};
     }
 
+    vector<vector<string>>
+    ElementWiseObj::inferSymbols(const TensorVec &inputs) const
+    {
+        const auto A = inputs[0], B = inputs[1];
+        return {infer_broadcast_symbols(A->getDims(), A->getSymbolicDims(),
+                                        B->getDims(), B->getSymbolicDims())};
+    }
+
     std::string ElementWiseObj::toString() const
     {
         std::ostringstream os;
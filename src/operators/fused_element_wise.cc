@@ -0,0 +1,94 @@
+#include "operators/fused_element_wise.h"
+#include "utils/operator_utils.h"
+
+namespace infini
+{
+    FusedElementWiseObj::FusedElementWiseObj(GraphObj *graph, TensorVec inputs,
+                                             Tensor output,
+                                             vector<FusedElementWiseStep> steps)
+        : OperatorObj(OpType::FusedElementWise, inputs, {output}),
+          steps(std::move(steps))
+    {
+        IT_ASSERT(!this->steps.empty());
+        int nValues = this->inputs.size();
+        for (auto &step : this->steps)
+        {
+            IT_ASSERT(step.lhs >= 0 && step.lhs < nValues);
+            IT_ASSERT(step.rhs < nValues);
+            ++nValues;
+        }
+        IT_ASSERT(checkValid(graph));
+    }
+
+    optional<vector<Shape>>
+    FusedElementWiseObj::inferShape(const TensorVec &inputs)
+    {
+        // every input contributes to the output, so it is their broadcast
+        Shape shape = inputs[0]->getDims();
+        for (size_t i = 1; i < inputs.size(); ++i)
+            shape = infer_broadcast(shape, inputs[i]->getDims());
+        return {{shape}};
+    }
+
+    vector<vector<string>>
+    FusedElementWiseObj::inferSymbols(const TensorVec &inputs) const
+    {
+        Shape shape = inputs[0]->getDims();
+        auto symbols = inputs[0]->getSymbolicDims();
+        for (size_t i = 1; i < inputs.size(); ++i)
+        {
+            symbols = infer_broadcast_symbols(shape, symbols,
+                                              inputs[i]->getDims(),
+                                              inputs[i]->getSymbolicDims());
+            shape = infer_broadcast(shape, inputs[i]->getDims());
+        }
+        return {symbols};
+    }
+
+    size_t FusedElementWiseObj::hashAttributes() const
+    {
+        size_t seed = 0;
+        for (auto &step : steps)
+        {
+            hash_combine(seed, step.type.underlying());
+            hash_combine(seed, step.lhs);
+            hash_combine(seed, step.rhs);
+            hash_combine(seed, step.min);
+            hash_combine(seed, step.max);
+        }
+        return seed;
+    }
+
+    bool FusedElementWiseObj::equalAttributes(const OperatorObj &other) const
+    {
+        auto &otherSteps = static_cast<const FusedElementWiseObj &>(other).steps;
+        if (steps.size() != otherSteps.size())
+            return false;
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            auto &a = steps[i], &b = otherSteps[i];
+            if (!(a.type == b.type) || a.lhs != b.lhs || a.rhs != b.rhs ||
+                a.min != b.min || a.max != b.max)
+                return false;
+        }
+        return true;
+    }
+
+    std::string FusedElementWiseObj::toString() const
+    {
+        std::ostringstream os;
+        os << type.toString() << "[" << getGuid() << "]";
+        os << "(";
+        for (auto &input : inputs)
+            os << vecToString(input->getDims()) << ",";
+        os << "steps=";
+        for (size_t i = 0; i < steps.size(); ++i)
+            os << (i ? " " : "") << steps[i].type.toString();
+        os << ",";
+        for (size_t i = 0; i < inputs.size(); ++i)
+            os << "input" << i << "=" << inputs[i]->getGuid() << ",";
+        os << "output=" << outputs[0]->getGuid() << ")";
+        return os.str();
+    }
+
+}; // namespace infini
@@ -1,23 +1,54 @@
 #include "operators/matmul.h"
+#include "utils/operator_utils.h"
 
 namespace infini
 {
 
     MatmulObj::MatmulObj(GraphObj *graph, Tensor A, Tensor B, Tensor C, bool transA,
-                         bool transB)
-        : OperatorObj(OpType::MatMul, TensorVec{A, B}, {C}),
-          transA(transA), transB(transB)
+                         bool transB, Tensor bias, ActType act,
+                         std::optional<float> clipMin,
+                         std::optional<float> clipMax)
+        : OperatorObj(OpType::MatMul,
+                      bias ? TensorVec{A, B, bias} : TensorVec{A, B}, {C}),
+          transA(transA), transB(transB), act(act), clipMin(clipMin),
+          clipMax(clipMax)
     {
         IT_ASSERT(checkValid(graph));
     }
 
+    size_t MatmulObj::hashAttributes() const
+    {
+        size_t seed = 0;
+        hash_combine(seed, transA);
+        hash_combine(seed, transB);
+        hash_combine(seed, act);
+        hash_combine(seed, clipMin);
+        hash_combine(seed, clipMax);
+        return seed;
+    }
+
+    bool MatmulObj::equalAttributes(const OperatorObj &other) const
+    {
+        auto &matmul = static_cast<const MatmulObj &>(other);
+        return transA == matmul.transA && transB == matmul.transB &&
+               act == matmul.act && clipMin == matmul.clipMin &&
+               clipMax == matmul.clipMax;
+    }
+
     string MatmulObj::toString() const
     {
         std::ostringstream os;
         os << "Matmul([" << (transA ? "A^T" : "A") << "," << (transB ? "B^T" : "B]")
            << ",A=" << inputs[0]->getGuid()
            << ",B=" << inputs[1]->getGuid() << ",C=" << outputs[0]->getGuid()
-           << ",mnk=[" << m << "," << n << "," << k << "])";
+           << ",mnk=[" << m << "," << n << "," << k << "]";
+        if (auto bias = getBias())
+            os << ",bias=" << bias->getGuid();
+        if (act == ActType::Relu)
+            os << ",act=Relu";
+        else if (act == ActType::Clip)
+            os << ",act=Clip";
+        os << ")";
         return os.str();
     }
 
@@ -28,7 +59,7 @@ namespace infini
         // REF: https://github.com/onnx/onnx/blob/main/docs/Operators.md#gemm
         // =================================== 作业 ===================================
         // 检查输入数量
-        if (inputs.size() != 2) {
+        if (inputs.size() != 2 && inputs.size() != 3) {
             return std::nullopt;
         }
 
@@ -66,13 +97,14 @@ namespace infini
         // 计算输出形状
         vector<Shape> outputShapes;
 
-        // 处理广播维度
+        // 处理广播维度，批维度右对齐
         size_t broadcastRank = std::max(rankA, rankB);
         Shape broadcastDims(broadcastRank - 2);
 
         for (size_t i = 0; i < broadcastRank - 2; ++i) {
-            size_t dimA = (i < rankA - 2) ? dimsA[i] : 1;
-            size_t dimB = (i < rankB - 2) ? dimsB[i] : 1;
+            size_t offsetA = broadcastRank - rankA, offsetB = broadcastRank - rankB;
+            size_t dimA = (i >= offsetA) ? dimsA[i - offsetA] : 1;
+            size_t dimB = (i >= offsetB) ? dimsB[i - offsetB] : 1;
             
             if (dimA == dimB) {
                 broadcastDims[i] = dimA;
@@ -90,8 +122,38 @@ namespace infini
         outputShape.push_back(M);
         outputShape.push_back(N);
 
+        // 偏置须能广播到输出形状
+        if (inputs.size() == 3 &&
+            infer_broadcast(outputShape, inputs[2]->getDims()) != outputShape) {
+            return std::nullopt;
+        }
+        m = M;
+        n = N;
+        k = K_A;
+
         outputShapes.push_back(outputShape);
         return outputShapes;
     }
 
+    vector<vector<string>>
+    MatmulObj::inferSymbols(const TensorVec &inputs) const
+    {
+        const auto &A = inputs[0];
+        const auto &B = inputs[1];
+        auto dimsA = A->getDims(), dimsB = B->getDims();
+        size_t rankA = dimsA.size(), rankB = dimsB.size();
+        // the batch dims broadcast, the last two are M of A and N of B
+        auto symbolsA = A->getSymbolicDims(), symbolsB = B->getSymbolicDims();
+        symbolsA.resize(rankA);
+        symbolsB.resize(rankB);
+        auto ans = infer_broadcast_symbols(
+            Shape(dimsA.begin(), dimsA.end() - 2),
+            vector<string>(symbolsA.begin(), symbolsA.end() - 2),
+            Shape(dimsB.begin(), dimsB.end() - 2),
+            vector<string>(symbolsB.begin(), symbolsB.end() - 2));
+        ans.push_back(symbolsA[transA ? rankA - 1 : rankA - 2]);
+        ans.push_back(symbolsB[transB ? rankB - 2 : rankB - 1]);
+        return {ans};
+    }
+
 } // namespace infini
\ No newline at end of file
@@ -9,6 +9,7 @@ namespace infini
         auto rank = input->getRank();
         if (permute.empty())
         {
+            transposePermute.resize(rank);
             for (size_t i = 0; i < rank; ++i)
             {
                 transposePermute[i] = i;
@@ -41,6 +42,52 @@ namespace infini
         return vector<Shape>{output_dim};
     }
 
+    vector<vector<string>>
+    TransposeObj::inferSymbols(const TensorVec &inputs) const
+    {
+        const auto &symbols = inputs[0]->getSymbolicDims();
+        if (symbols.empty())
+            return vector<vector<string>>(1);
+        vector<string> ans(transposePermute.size());
+        for (size_t i = 0; i < ans.size(); ++i)
+            ans[i] = symbols[transposePermute[i]];
+        return {ans};
+    }
+
+    bool TransposeObj::isIdentity() const
+    {
+        for (size_t i = 0; i < transposePermute.size(); ++i)
+            if (transposePermute[i] != (int)i)
+                return false;
+        return true;
+    }
+
+    bool TransposeObj::swapsLastTwoDims() const
+    {
+        int rank = transposePermute.size();
+        if (rank < 2)
+            return false;
+        for (int i = 0; i < rank - 2; ++i)
+            if (transposePermute[i] != i)
+                return false;
+        return transposePermute[rank - 2] == rank - 1 &&
+               transposePermute[rank - 1] == rank - 2;
+    }
+
+    size_t TransposeObj::hashAttributes() const
+    {
+        size_t seed = 0;
+        for (auto dim : transposePermute)
+            hash_combine(seed, dim);
+        return seed;
+    }
+
+    bool TransposeObj::equalAttributes(const OperatorObj &other) const
+    {
+        return transposePermute ==
+               static_cast<const TransposeObj &>(other).transposePermute;
+    }
+
     std::string TransposeObj::toString() const
     {
         std::ostringstream os;
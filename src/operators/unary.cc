@@ -47,6 +47,20 @@ namespace infini
         return {{input_dim}};
     }
 
+    size_t ClipObj::hashAttributes() const
+    {
+        size_t seed = 0;
+        hash_combine(seed, minValue);
+        hash_combine(seed, maxValue);
+        return seed;
+    }
+
+    bool ClipObj::equalAttributes(const OperatorObj &other) const
+    {
+        auto &clip = static_cast<const ClipObj &>(other);
+        return minValue == clip.minValue && maxValue == clip.maxValue;
+    }
+
     std::string ClipObj::toString() const
     {
         std::ostringstream os;
@@ -90,6 +104,16 @@ namespace infini
         return {{inputs[0]->getDims()}};
     }
 
+    size_t CastObj::hashAttributes() const
+    {
+        return std::hash<CastType>{}(castType);
+    }
+
+    bool CastObj::equalAttributes(const OperatorObj &other) const
+    {
+        return castType == static_cast<const CastObj &>(other).castType;
+    }
+
     std::string CastObj::toString() const
     {
         std::ostringstream os;
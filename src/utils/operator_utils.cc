@@ -38,6 +38,51 @@ Shape infer_broadcast(const Shape &A, const Shape &B) {
     return result;
 }
 
+vector<string> infer_broadcast_symbols(const Shape &A,
+                                       const vector<string> &symbolsA,
+                                       const Shape &B,
+                                       const vector<string> &symbolsB) {
+    size_t rankA = A.size(), rankB = B.size();
+    size_t maxRank = std::max(rankA, rankB);
+    vector<string> result(maxRank);
+    for (size_t i = 0; i < maxRank; ++i) {
+        // fixed size 1 past the rank, as in infer_broadcast
+        int dimA = i < rankA ? A[rankA - 1 - i] : 1;
+        int dimB = i < rankB ? B[rankB - 1 - i] : 1;
+        string a = i < rankA && rankA - 1 - i < symbolsA.size()
+                       ? symbolsA[rankA - 1 - i]
+                       : "";
+        string b = i < rankB && rankB - 1 - i < symbolsB.size()
+                       ? symbolsB[rankB - 1 - i]
+                       : "";
+        auto &name = result[maxRank - 1 - i];
+        if (a == b)
+            name = a;
+        // a fixed 1 is stretched to the other dim
+        else if (a.empty() && dimA == 1)
+            name = b;
+        else if (b.empty() && dimB == 1)
+            name = a;
+        // a fixed size other than 1 wins, the symbol is 1 or equal to it
+        else if (a.empty() || b.empty())
+            name = "";
+        // whichever of the two is not 1 at run time
+        else
+            name = "max(" + a + "," + b + ")";
+    }
+    return result;
+}
+
+void get_broadcast_strides(const Shape &shape, size_t rank, size_t *strides) {
+    IT_ASSERT(shape.size() <= rank);
+    size_t p = 1, offset = rank - shape.size();
+    for (size_t i = rank; i-- > 0;) {
+        size_t dim = i >= offset ? shape[i - offset] : 1;
+        strides[i] = dim == 1 ? 0 : p;
+        p *= dim;
+    }
+}
+
 int get_real_axis(const int &axis, const int &rank) {
     IT_ASSERT(rank >= 1);
     IT_ASSERT(axis >= -rank && axis <= (rank - 1));
@@ -4,6 +4,7 @@
 #include "operators/unary.h"
 
 #include "test.h"
+#include <unistd.h>
 
 namespace infini
 {
@@ -70,4 +71,108 @@ namespace infini
         EXPECT_EQ(ptr1, ptr2);
     }
 
+    TEST(Allocator, testBestFit)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime, sizeof(uint64_t));
+        // layout: a(64) b(8) c(32) d(8)
+        size_t offsetA = allocator.alloc(64);
+        allocator.alloc(8);
+        size_t offsetC = allocator.alloc(32);
+        allocator.alloc(8);
+        allocator.free(offsetA, 64);
+        allocator.free(offsetC, 32);
+        // the 32-byte hole is the tightest fit, a first fit would pick a's
+        EXPECT_EQ(allocator.alloc(32), offsetC);
+        EXPECT_EQ(allocator.alloc(64), offsetA);
+        EXPECT_EQ(allocator.getPeak(), (size_t)112);
+    }
+
+    TEST(Allocator, testGrowArena)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        // requests larger than any free block grow the arena at the tail
+        size_t offsetA = allocator.alloc(1 << 20);
+        size_t offsetB = allocator.alloc(1 << 20);
+        EXPECT_EQ(offsetA, (size_t)0);
+        EXPECT_EQ(offsetB, (size_t)1 << 20);
+        // a freed tail block is extended rather than skipped
+        allocator.free(offsetB, 1 << 20);
+        EXPECT_EQ(allocator.alloc(3 << 20), offsetB);
+        EXPECT_EQ(allocator.getPeak(), (size_t)4 << 20);
+        // freeing everything coalesces back into a single block
+        allocator.free(offsetA, 1 << 20);
+        allocator.free(offsetB, 3 << 20);
+        EXPECT_EQ(allocator.getUsed(), (size_t)0);
+        EXPECT_EQ(allocator.alloc(4 << 20), (size_t)0);
+    }
+
+    TEST(Allocator, testAlignment)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        EXPECT_EQ(allocator.getAlignment(), (size_t)64);
+        EXPECT_EQ(allocator.alloc(4), (size_t)0);
+        EXPECT_EQ(allocator.alloc(100), (size_t)64);
+        EXPECT_EQ(allocator.getPeak(), (size_t)192);
+        EXPECT_EQ((uintptr_t)allocator.getPtr() % 64, (uintptr_t)0);
+        EXPECT_THROW(Allocator(runtime, 48), Exception);
+
+        Graph g = make_ref<GraphObj>(runtime, 256);
+        auto i = g->addTensor({3}, DataType::Float32);
+        auto op = g->addOp<ReluObj>(i, nullptr);
+        g->dataMalloc();
+        for (auto tensor : {i, op->getOutput()})
+        {
+            EXPECT_EQ(tensor->getAlignment(), (size_t)256);
+            EXPECT_EQ((uintptr_t)tensor->getRawDataPtr<void *>() % 256,
+                      (uintptr_t)0);
+        }
+    }
+
+    TEST(Allocator, testMmapRuntime)
+    {
+        for (auto hugePages : {HugePageMode::None, HugePageMode::Transparent,
+                               HugePageMode::Explicit})
+        {
+            auto runtime = make_ref<NativeCpuRuntimeObj>(
+                CpuAllocConfig{CpuAllocMode::Mmap, hugePages, true});
+            Graph g = make_ref<GraphObj>(runtime);
+            auto i = g->addTensor({2, 3}, DataType::Float32);
+            auto op = g->addOp<ReluObj>(i, nullptr);
+            g->dataMalloc();
+            EXPECT_EQ((uintptr_t)i->getRawDataPtr<void *>() % 64, (uintptr_t)0);
+            i->setData(IncrementalGenerator());
+            runtime->run(g);
+            EXPECT_TRUE(op->getOutput()->equalData(i));
+        }
+        // the host's huge page size, or the configured one
+        const size_t pageSize = sysconf(_SC_PAGESIZE);
+        for (auto hugePages : {HugePageMode::Transparent, HugePageMode::Explicit})
+        {
+            auto runtime = make_ref<NativeCpuRuntimeObj>(
+                CpuAllocConfig{CpuAllocMode::Mmap, hugePages});
+            size_t size = runtime->getHugePageSize();
+            EXPECT_GE(size, pageSize);
+            EXPECT_EQ(size & (size - 1), (size_t)0);
+            runtime->setAllocConfig(
+                {CpuAllocMode::Mmap, hugePages, false, 4 * size});
+            EXPECT_EQ(runtime->getHugePageSize(), 4 * size);
+            void *ptr = runtime->alloc(100, 64);
+            ((char *)ptr)[4 * size - 1] = 1;
+            runtime->dealloc(ptr);
+        }
+        EXPECT_EQ(NativeCpuRuntimeObj().getHugePageSize(), (size_t)0);
+
+        // switching modes does not break freeing earlier allocations
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        void *heap = runtime->alloc(100, 64);
+        runtime->setAllocConfig({CpuAllocMode::Mmap});
+        void *mapped = runtime->alloc(100, 64);
+        EXPECT_EQ(((char *)mapped)[99], 0);
+        runtime->dealloc(heap);
+        runtime->dealloc(mapped);
+    }
+
 } // namespace infini
@@ -0,0 +1,88 @@
+#include "core/execution_context.h"
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <thread>
+
+namespace infini
+{
+    TEST(ExecutionContext, ConcurrentRuns)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({3, 4}, DataType::Float32);
+        w->setWeight();
+        auto matmul = g->addOp<MatmulObj>(i, w, nullptr);
+        auto relu = g->addOp<ReluObj>(matmul->getOutput(), nullptr);
+        auto concat = g->addOp<ConcatObj>(
+            TensorVec{relu->getOutput(), matmul->getOutput()}, nullptr, 1);
+        auto t = g->addOp<TransposeObj>(concat->getOutput(), nullptr,
+                                        Shape{1, 0});
+        auto output = t->getOutput();
+        g->bindWeights();
+        w->setData(IncrementalGenerator());
+
+        // request k feeds i[j] = j - k
+        auto generator = [](int k)
+        {
+            return [k](void *ptr, size_t size, DataType)
+            {
+                for (size_t j = 0; j < size; ++j)
+                    static_cast<float *>(ptr)[j] = (float)j - k;
+            };
+        };
+        const int nRequests = 4;
+        vector<vector<float>> expected;
+        g->dataMalloc();
+        for (int k = 0; k < nRequests; ++k)
+        {
+            i->setData(generator(k));
+            runtime->run(g);
+            auto p = output->getRawDataPtr<float *>();
+            expected.emplace_back(p, p + output->size());
+        }
+
+        auto plan = make_ref<CompiledPlanObj>(g);
+        EXPECT_EQ(plan->getArenaSize(), g->getMemoryReport().peak);
+        // the plan keeps the shapes it was compiled at
+        i->setShape({1, 3});
+        g->shape_infer();
+        EXPECT_EQ(output->getDims(), (Shape{8, 1}));
+        vector<ExecutionContext> contexts;
+        vector<vector<float>> results(nRequests);
+        vector<std::thread> threads;
+        for (int k = 0; k < nRequests; ++k)
+            contexts.emplace_back(make_ref<ExecutionContextObj>(plan));
+        for (int k = 0; k < nRequests; ++k)
+            threads.emplace_back(
+                [&, k]()
+                {
+                    auto &context = contexts[k];
+                    auto input = context->getInputs()[0];
+                    input->setData(generator(k));
+                    for (int round = 0; round < 100; ++round)
+                        runtime->run(context);
+                    auto result = context->getTensor(*output);
+                    auto p = result->getRawDataPtr<float *>();
+                    results[k].assign(p, p + result->size());
+                });
+        for (auto &thread : threads)
+            thread.join();
+        EXPECT_EQ(results, expected);
+
+        // every context has its own activations and shares the weights
+        EXPECT_NE(contexts[0]->getRawDataPtr<void *>(output),
+                  contexts[1]->getRawDataPtr<void *>(output));
+        EXPECT_EQ(contexts[0]->getRawDataPtr<void *>(w),
+                  w->getRawDataPtr<void *>());
+        EXPECT_EQ(contexts[0]->getOutputs()[0]->getDims(), (Shape{8, 2}));
+        EXPECT_EQ(contexts[0]->getOperators().size(), plan->getNumOperators());
+    }
+
+} // namespace infini
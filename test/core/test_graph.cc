@@ -1,8 +1,11 @@
 #include "core/graph.h"
 #include "core/kernel.h"
 #include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
 #include "operators/matmul.h"
 #include "operators/transpose.h"
+#include "operators/unary.h"
 
 #include "test.h"
 
@@ -37,4 +40,775 @@ namespace infini
         EXPECT_EQ(op->getTransA(), false);
         EXPECT_EQ(op->getTransB(), true);
     }
-}
\ No newline at end of file
+
+    TEST(Graph, OptimizeLevelsAndStats)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto build = [&]()
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor a = g->addTensor({2, 4, 3}, DataType::Float32);
+            Tensor b = g->addTensor({2, 4, 5}, DataType::Float32);
+            auto t1 = g->addOp<TransposeObj>(a, nullptr, Shape{0, 2, 1});
+            auto t2 = g->addOp<TransposeObj>(t1->getOutput(), nullptr,
+                                             Shape{0, 2, 1});
+            auto t3 = g->addOp<TransposeObj>(t2->getOutput(), nullptr,
+                                             Shape{0, 2, 1});
+            g->addOp<MatmulObj>(t3->getOutput(), b, nullptr);
+            return g;
+        };
+        Graph g = build();
+        EXPECT_TRUE(g->optimize({0}).empty());
+        EXPECT_EQ(g->getOperators().size(), (size_t)4);
+
+        // t1 and t2 compose into an identity that is bypassed, then t3 folds
+        // into the matmul
+        auto stats = g->optimize();
+        ASSERT_EQ(g->getOperators().size(), (size_t)1);
+        auto matmul = as<MatmulObj>(g->getOperators()[0]);
+        EXPECT_TRUE(matmul->getTransA());
+        EXPECT_EQ(g->getTensors().size(), (size_t)3);
+        EXPECT_TRUE(g->checkValid());
+        size_t rewrites = 0;
+        for (auto &pass : stats)
+        {
+            // one round that rewrites, one that reaches the fixpoint
+            EXPECT_EQ(pass.runs, (size_t)2);
+            rewrites += pass.rewrites;
+        }
+        EXPECT_EQ(rewrites, (size_t)3);
+    }
+
+    TEST(Graph, FoldTransposeIntoMatmulBias)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runGraph = [&](bool optimize)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor a = g->addTensor({4, 4}, DataType::Float32);
+            Tensor b = g->addTensor({4, 4}, DataType::Float32);
+            auto t = g->addOp<TransposeObj>(b, nullptr, Shape{1, 0});
+            // the transposed tensor is both the second input and the bias
+            auto matmul = g->addOp<MatmulObj>(a, t->getOutput(), nullptr, false,
+                                              false, t->getOutput());
+            if (optimize)
+            {
+                g->optimize({1});
+                EXPECT_EQ(g->getOperators().size(), (size_t)2);
+                EXPECT_FALSE(matmul->getTransB());
+                EXPECT_EQ(matmul->getBias(), t->getOutput());
+            }
+            g->dataMalloc();
+            a->setData(IncrementalGenerator());
+            b->setData(IncrementalGenerator());
+            runtime->run(g);
+            auto p = matmul->getOutput()->getRawDataPtr<float *>();
+            return vector<float>(p, p + 16);
+        };
+        EXPECT_EQ(runGraph(true), runGraph(false));
+    }
+
+    TEST(Graph, ComposeTranspose)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runGraph = [&](bool optimize)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor a = g->addTensor({2, 3, 4}, DataType::Float32);
+            auto t1 = g->addOp<TransposeObj>(a, nullptr, Shape{1, 0, 2});
+            auto t2 = g->addOp<TransposeObj>(t1->getOutput(), nullptr,
+                                             Shape{0, 2, 1});
+            auto t3 = g->addOp<TransposeObj>(t2->getOutput(), nullptr,
+                                             Shape{0, 1, 2});
+            // t1 has a second consumer, so it stays
+            auto r1 = g->addOp<ReluObj>(t1->getOutput(), nullptr);
+            auto r2 = g->addOp<ReluObj>(t3->getOutput(), nullptr);
+            if (optimize)
+            {
+                g->optimize();
+                // the chain collapses into t3, reading a with the composed
+                // permutation
+                EXPECT_EQ(g->getOperators(), (OpVec{t1, t3, r1, r2}));
+                EXPECT_EQ(t3->getInputs(0), a);
+                EXPECT_EQ(as<TransposeObj>(t3)->getPermute(),
+                          (vector<int>{1, 2, 0}));
+                EXPECT_EQ(r2->getInputs(0), t3->getOutput());
+                EXPECT_TRUE(g->checkValid());
+            }
+            g->dataMalloc();
+            a->setData(IncrementalGenerator());
+            runtime->run(g);
+            auto p1 = r1->getOutput()->getRawDataPtr<float *>();
+            auto p2 = r2->getOutput()->getRawDataPtr<float *>();
+            return std::make_pair(vector<float>(p1, p1 + 24),
+                                  vector<float>(p2, p2 + 24));
+        };
+        EXPECT_EQ(runGraph(true), runGraph(false));
+    }
+
+    TEST(Graph, SinkTranspose)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runGraph = [&](bool optimize)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor a = g->addTensor({2, 3, 4}, DataType::Float32);
+            Tensor b = g->addTensor({2, 1, 1}, DataType::Float32);
+            Tensor x = g->addTensor({2, 4, 3}, DataType::Float32);
+            Tensor y = g->addTensor({2, 4, 5}, DataType::Float32);
+            // t1 sinks past the relu and the add, then cancels against t2
+            auto t1 = g->addOp<TransposeObj>(a, nullptr, Shape{0, 2, 1});
+            auto r1 = g->addOp<ReluObj>(t1->getOutput(), nullptr);
+            auto add = g->addOp<AddObj>(r1->getOutput(), b, nullptr);
+            auto t2 = g->addOp<TransposeObj>(add->getOutput(), nullptr,
+                                             Shape{0, 2, 1});
+            auto o1 = g->addOp<ReluObj>(t2->getOutput(), nullptr);
+            // t3 sinks past the clip into the matmul
+            auto t3 = g->addOp<TransposeObj>(x, nullptr, Shape{0, 2, 1});
+            auto clip =
+                g->addOp<ClipObj>(t3->getOutput(), nullptr, 0.0f, 10.0f);
+            auto matmul = g->addOp<MatmulObj>(clip->getOutput(), y, nullptr);
+            // t4 has two readers, so t5 is hoisted above the relu instead
+            auto t4 = g->addOp<TransposeObj>(a, nullptr, Shape{1, 0, 2});
+            auto o2 = g->addOp<ClipObj>(t4->getOutput(), nullptr, 0.0f, 3.0f);
+            auto r2 = g->addOp<ReluObj>(t4->getOutput(), nullptr);
+            auto t5 = g->addOp<TransposeObj>(r2->getOutput(), nullptr,
+                                             Shape{1, 0, 2});
+            auto o3 = g->addOp<ClipObj>(t5->getOutput(), nullptr, 1.0f, 5.0f);
+            if (optimize)
+            {
+                g->optimize({1});
+                OpVec transposes;
+                for (auto &op : g->getOperators())
+                    if (op->getOpType() == OpType::Transpose)
+                        transposes.emplace_back(op);
+                EXPECT_EQ(transposes, (OpVec{t4}));
+                EXPECT_EQ(g->getOperators().size(), (size_t)8);
+                EXPECT_TRUE(matmul->getTransA());
+                EXPECT_EQ(o3->getInputs(0)->getSource()->getInputs(0), a);
+                EXPECT_TRUE(g->checkValid());
+            }
+            g->dataMalloc();
+            a->setData(IncrementalGenerator());
+            b->setData(IncrementalGenerator());
+            x->setData(IncrementalGenerator());
+            y->setData(IncrementalGenerator());
+            runtime->run(g);
+            auto collect = [](const Operator &op)
+            {
+                auto output = op->getOutput();
+                auto p = output->getRawDataPtr<float *>();
+                return vector<float>(p, p + output->size());
+            };
+            return vector<vector<float>>{collect(o1), collect(matmul),
+                                         collect(o2), collect(o3)};
+        };
+        EXPECT_EQ(runGraph(true), runGraph(false));
+    }
+
+    TEST(Graph, FoldConstants)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runGraph = [&](bool optimize)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+            Tensor w = g->addTensor({4, 3}, DataType::Float32);
+            w->setWeight();
+            auto t = g->addOp<TransposeObj>(w, nullptr, Shape{1, 0});
+            auto add = g->addOp<AddObj>(i, t->getOutput(), nullptr);
+            if (optimize)
+            {
+                // the weights hold data before optimize, so the transpose
+                // runs once and its output becomes a weight
+                g->bindWeights();
+                w->setData(IncrementalGenerator());
+                size_t weightBytes = g->getWeightRegion()->getSize();
+                g->optimize();
+                // the block of w is released once the transpose is folded
+                EXPECT_EQ(g->getWeightRegion()->getSize(), weightBytes);
+                EXPECT_EQ(g->getOperators(), (OpVec{add}));
+                EXPECT_TRUE(t->getOutput()->isWeight());
+                EXPECT_FALSE(t->getOutput()->getSource());
+                EXPECT_EQ(g->getTensor(w->getFuid()), nullptr);
+                EXPECT_TRUE(g->checkValid());
+            }
+            g->dataMalloc();
+            if (!optimize)
+                w->setData(IncrementalGenerator());
+            i->setData(IncrementalGenerator());
+            runtime->run(g);
+            auto p = add->getOutput()->getRawDataPtr<float *>();
+            return vector<float>(p, p + 24);
+        };
+        EXPECT_EQ(runGraph(true), runGraph(false));
+    }
+
+    TEST(Graph, EliminateCommonSubexpression)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runGraph = [&](bool optimize)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor a = g->addTensor({2, 3, 4}, DataType::Float32);
+            auto t1 = g->addOp<TransposeObj>(a, nullptr, Shape{1, 0, 2});
+            auto t2 = g->addOp<TransposeObj>(a, nullptr, Shape{1, 0, 2});
+            auto r1 = g->addOp<ReluObj>(t1->getOutput(), nullptr);
+            auto r2 = g->addOp<ReluObj>(t2->getOutput(), nullptr);
+            auto mul = g->addOp<MulObj>(r1->getOutput(), r2->getOutput(),
+                                        nullptr);
+            // the bounds differ, so both clips stay
+            auto c1 = g->addOp<ClipObj>(mul->getOutput(), nullptr, 0.0f, 5.0f);
+            auto c2 = g->addOp<ClipObj>(mul->getOutput(), nullptr, 0.0f, 6.0f);
+            auto add = g->addOp<AddObj>(c1->getOutput(), c2->getOutput(),
+                                        nullptr);
+            if (optimize)
+            {
+                // merging t2 into t1 makes r2 a duplicate of r1 in the same
+                // run
+                g->optimize({1});
+                EXPECT_EQ(g->getOperators(), (OpVec{t1, r1, mul, c1, c2, add}));
+                EXPECT_EQ(mul->getInputs(0), r1->getOutput());
+                EXPECT_EQ(mul->getInputs(1), r1->getOutput());
+                EXPECT_TRUE(g->checkValid());
+            }
+            g->dataMalloc();
+            a->setData(IncrementalGenerator());
+            runtime->run(g);
+            auto p = add->getOutput()->getRawDataPtr<float *>();
+            return vector<float>(p, p + 24);
+        };
+        EXPECT_EQ(runGraph(true), runGraph(false));
+    }
+
+    TEST(Graph, EliminateDeadCode)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({2, 3}, DataType::Float32);
+        Tensor d = g->addTensor({2, 3}, DataType::Float32);
+        auto o = g->addOp<ReluObj>(a, nullptr);
+        auto mul = g->addOp<MulObj>(o->getOutput(), a, nullptr);
+        // nothing declared depends on these
+        auto dead1 = g->addOp<ClipObj>(o->getOutput(), nullptr, 0.0f, 1.0f);
+        g->addOp<ReluObj>(dead1->getOutput(), nullptr);
+        g->addOp<ReluObj>(d, nullptr);
+        g->setInputs({a});
+        g->setOutputs({o->getOutput(), mul->getOutput()});
+        EXPECT_EQ(g->getOutputs(), (TensorVec{o->getOutput(), mul->getOutput()}));
+
+        g->optimize({1});
+        EXPECT_EQ(g->getOperators(), (OpVec{o, mul}));
+        EXPECT_EQ(g->getTensors(),
+                  (TensorVec{a, o->getOutput(), mul->getOutput()}));
+        EXPECT_TRUE(g->checkValid());
+
+        // a declared output stays valid even though the mul reads it
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(o->getOutput()->equalData(vector<float>{0, 1, 2, 3, 4, 5}));
+        EXPECT_TRUE(
+            mul->getOutput()->equalData(vector<float>{0, 1, 4, 9, 16, 25}));
+    }
+
+    TEST(Graph, EliminateDeadCodeReleasesWeights)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({3, 4}, DataType::Float32);
+        w->setWeight();
+        auto o = g->addOp<ReluObj>(a, nullptr);
+        g->addOp<MatmulObj>(a, w, nullptr);
+        g->setInputs({a});
+        g->setOutputs({o->getOutput()});
+        g->bindWeights();
+        // holding the region does not share it with another graph
+        auto region = g->getWeightRegion();
+        EXPECT_FALSE(g->sharesWeightRegion());
+        size_t weightBytes = region->getSize();
+        EXPECT_GT(weightBytes, (size_t)0);
+
+        // the dead matmul goes, and with it the block of its weight
+        g->optimize({1});
+        EXPECT_EQ(g->getOperators(), (OpVec{o}));
+        EXPECT_EQ(g->getTensor(w->getFuid()), nullptr);
+        EXPECT_FALSE(region->contains(w));
+        EXPECT_LT(region->getSize(), weightBytes);
+    }
+
+    TEST(Graph, FuseElementWise)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runGraph = [&](bool optimize)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+            Tensor w = g->addTensor({4}, DataType::Float32);
+            auto sub = g->addOp<SubObj>(i, w, nullptr);
+            auto relu = g->addOp<ReluObj>(sub->getOutput(), nullptr);
+            auto clip =
+                g->addOp<ClipObj>(relu->getOutput(), nullptr, 1.0f, 8.0f);
+            auto add = g->addOp<AddObj>(w, clip->getOutput(), nullptr);
+            auto branch = g->addOp<ReluObj>(add->getOutput(), nullptr);
+            auto mul = g->addOp<MulObj>(add->getOutput(), branch->getOutput(),
+                                        nullptr);
+            auto o = mul->getOutput();
+            if (optimize)
+            {
+                g->optimize();
+                // add's output is read twice, so the first round cuts the
+                // chain there; once the mul chain is fused it reads add's
+                // output only once, and the next round merges the two
+                auto ops = g->getOperators();
+                EXPECT_EQ(ops.size(), (size_t)1);
+                EXPECT_EQ(ops[0]->getOpType(), OpType::FusedElementWise);
+                EXPECT_EQ(ops[0]->getInputs(), (TensorVec{w, i}));
+                EXPECT_EQ(ops[0]->getOutput(), o);
+                EXPECT_EQ(g->getTensors().size(), (size_t)3);
+                EXPECT_TRUE(g->checkValid());
+            }
+            g->dataMalloc();
+            i->setData(IncrementalGenerator());
+            w->setData(IncrementalGenerator());
+            runtime->run(g);
+            auto ptr = o->getRawDataPtr<float *>();
+            return vector<float>(ptr, ptr + o->size());
+        };
+        EXPECT_EQ(runGraph(true), runGraph(false));
+    }
+
+    TEST(Graph, FuseMatmulEpilogue)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runGraph = [&](bool optimize)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor a = g->addTensor({2, 3, 4}, DataType::Float32);
+            Tensor b = g->addTensor({4, 5}, DataType::Float32);
+            Tensor bias = g->addTensor({3, 1}, DataType::Float32);
+            auto matmul = g->addOp<MatmulObj>(a, b, nullptr);
+            auto add = g->addOp<AddObj>(bias, matmul->getOutput(), nullptr);
+            auto clip =
+                g->addOp<ClipObj>(add->getOutput(), nullptr, 100.0f, 300.0f);
+            auto o = clip->getOutput();
+            if (optimize)
+            {
+                g->optimize();
+                auto ops = g->getOperators();
+                EXPECT_EQ(ops.size(), (size_t)1);
+                auto fused = as<MatmulObj>(ops[0]);
+                EXPECT_EQ(fused->getBias(), bias);
+                EXPECT_EQ(fused->getAct(), ActType::Clip);
+                EXPECT_EQ(fused->getOutput(), o);
+                EXPECT_TRUE(g->checkValid());
+            }
+            g->dataMalloc();
+            a->setData(IncrementalGenerator());
+            b->setData(IncrementalGenerator());
+            bias->setData(IncrementalGenerator());
+            runtime->run(g);
+            auto ptr = o->getRawDataPtr<float *>();
+            return vector<float>(ptr, ptr + o->size());
+        };
+        EXPECT_EQ(runGraph(true), runGraph(false));
+    }
+
+    TEST(Graph, TopoSort)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        Tensor t1 = g->addTensor({2, 3}, DataType::Float32);
+        Tensor t2 = g->addTensor({2, 3}, DataType::Float32);
+        Tensor o = g->addTensor({2, 3}, DataType::Float32);
+        // consumers first, so the list has to be sorted again
+        auto add = g->addOpWithOutputs<AddObj>(t1, t2, o);
+        auto r2 = g->addOpWithOutputs<ReluObj>(t1, t2);
+        auto r1 = g->addOpWithOutputs<ReluObj>(i, t1);
+        EXPECT_TRUE(g->topo_sort());
+        EXPECT_EQ(g->getOperators(), (OpVec{r1, r2, add}));
+        // appending at the end keeps the order
+        auto r3 = g->addOp<ReluObj>(o, nullptr);
+        g->removeOperator(r2);
+        EXPECT_EQ(g->getOperators(), (OpVec{r1, add, r3}));
+    }
+
+    TEST(Graph, TopoSortKeepsValidOrder)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        Tensor t = g->addTensor({2, 3}, DataType::Float32);
+        // only the consumer of t is out of place, the ops that are already
+        // in a valid order keep it even though c is ready before b
+        auto x = g->addOp<ReluObj>(t, nullptr);
+        auto a = g->addOp<ReluObj>(i, nullptr);
+        auto b = g->addOp<ReluObj>(a->getOutput(), nullptr);
+        auto c = g->addOp<ReluObj>(i, nullptr);
+        auto p = g->addOpWithOutputs<ReluObj>(i, t);
+        EXPECT_TRUE(g->topo_sort());
+        EXPECT_EQ(g->getOperators(), (OpVec{a, b, c, p, x}));
+    }
+
+    TEST(Graph, IndexedRemoval)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto r1 = g->addOp<ReluObj>(i, nullptr);
+        auto r2 = g->addOp<ReluObj>(r1->getOutput(), nullptr);
+        auto r3 = g->addOp<ReluObj>(r2->getOutput(), nullptr);
+        auto t = r2->getOutput();
+        EXPECT_EQ(g->getTensor(t->getFuid()), t);
+        EXPECT_EQ(g->getOperator(r2->getGuid()), r2);
+        g->removeOperator(r2);
+        g->removeTensor(t);
+        // removing twice is a no-op
+        g->removeTensor(t);
+        EXPECT_EQ(g->getTensor(t->getFuid()), nullptr);
+        EXPECT_EQ(g->getOperator(r2->getGuid()), nullptr);
+        EXPECT_EQ(g->getOperators(), (OpVec{r1, r3}));
+        EXPECT_EQ(g->getTensors().size(), (size_t)3);
+        // the slots after the removed ones are reindexed by the compaction
+        auto o = r3->getOutput();
+        EXPECT_EQ(g->getTensor(o->getFuid()), o);
+        EXPECT_EQ(g->getOperator(r3->getGuid()), r3);
+    }
+
+    TEST(Graph, DataMallocReuse)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+        auto t1 = g->addOp<TransposeObj>(i, nullptr, Shape{0, 2, 1});
+        auto t2 = g->addOp<TransposeObj>(t1->getOutput(), nullptr, Shape{0, 2, 1});
+        auto t3 = g->addOp<TransposeObj>(t2->getOutput(), nullptr, Shape{0, 2, 1});
+        auto t4 = g->addOp<TransposeObj>(t3->getOutput(), nullptr, Shape{0, 2, 1});
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        // o1 dies at t2, so o3 reuses its block; the pinned input and output
+        // keep their own blocks
+        auto o1 = t1->getOutput(), o3 = t3->getOutput(), o = t4->getOutput();
+        EXPECT_EQ(o1->getRawDataPtr<void *>(), o3->getRawDataPtr<void *>());
+        EXPECT_NE(i->getRawDataPtr<void *>(), o->getRawDataPtr<void *>());
+        EXPECT_NE(o1->getRawDataPtr<void *>(), o->getRawDataPtr<void *>());
+        EXPECT_TRUE(o->equalData(i));
+    }
+
+    TEST(Graph, DataMallocInPlace)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+        Tensor w = g->addTensor({4}, DataType::Float32);
+        auto sub = g->addOp<SubObj>(i, w, nullptr);
+        auto relu = g->addOp<ReluObj>(sub->getOutput(), nullptr);
+        auto clip = g->addOp<ClipObj>(relu->getOutput(), nullptr, 1.0f, 8.0f);
+        auto add = g->addOp<AddObj>(w, clip->getOutput(), nullptr);
+        auto branch = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        auto mul = g->addOp<MulObj>(add->getOutput(), branch->getOutput(),
+                                    nullptr);
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+        w->setData(OneGenerator());
+        runtime->run(g);
+        // the chain sub -> relu -> clip -> add runs in one block, the graph
+        // input is never overwritten
+        auto block = sub->getOutput()->getRawDataPtr<void *>();
+        EXPECT_NE(i->getRawDataPtr<void *>(), block);
+        EXPECT_EQ(relu->getOutput()->getRawDataPtr<void *>(), block);
+        EXPECT_EQ(clip->getOutput()->getRawDataPtr<void *>(), block);
+        EXPECT_EQ(add->getOutput()->getRawDataPtr<void *>(), block);
+        // add's output has two consumers, so the relu branch gets a new block
+        EXPECT_NE(branch->getOutput()->getRawDataPtr<void *>(), block);
+        vector<float> ans;
+        for (int k = 0; k < 24; ++k)
+        {
+            float v = std::min(std::max(k - 1.0f, 1.0f), 8.0f) + 1;
+            ans.emplace_back(v * v);
+        }
+        EXPECT_TRUE(mul->getOutput()->equalData(ans));
+        EXPECT_TRUE(i->equalData(vector<float>{0,  1,  2,  3,  4,  5,  6,  7,
+                                               8,  9,  10, 11, 12, 13, 14, 15,
+                                               16, 17, 18, 19, 20, 21, 22, 23}));
+    }
+
+    TEST(Graph, DataMallocConcatSlices)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({1, 2, 3}, DataType::Float32);
+        Tensor b = g->addTensor({1, 4, 3}, DataType::Float32);
+        Tensor c = g->addTensor({1, 1, 3}, DataType::Float32);
+        auto r1 = g->addOp<ReluObj>(a, nullptr);
+        auto r2 = g->addOp<ReluObj>(b, nullptr);
+        auto concat = g->addOp<ConcatObj>(
+            TensorVec{r1->getOutput(), r2->getOutput(), c}, nullptr, 1);
+        auto relu = g->addOp<ReluObj>(concat->getOutput(), nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        b->setData(IncrementalGenerator());
+        c->setData(IncrementalGenerator());
+        runtime->run(g);
+        // the relus write their slices of the concat output, the graph input
+        // is still copied
+        auto block = concat->getOutput()->getRawDataPtr<float *>();
+        EXPECT_EQ(r1->getOutput()->getRawDataPtr<float *>(), block);
+        EXPECT_EQ(r2->getOutput()->getRawDataPtr<float *>(), block + 6);
+        EXPECT_NE(c->getRawDataPtr<float *>(), block + 18);
+        EXPECT_TRUE(relu->getOutput()->equalData(
+            vector<float>{0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                          11, 0, 1, 2}));
+        // a slice is reported with its own size, inside the arena
+        auto &report = g->getMemoryReport();
+        for (auto &record : report.tensors)
+            for (size_t step = record.firstUse; step <= record.lastUse; ++step)
+                EXPECT_LE(record.offset + record.size,
+                          report.steps[step].extentBytes);
+        for (auto &record : report.tensors)
+            if (record.fuid == r2->getOutput()->getFuid())
+            {
+                EXPECT_EQ(record.size, r2->getOutput()->getBytes());
+            }
+    }
+
+    TEST(Graph, ShapeInferIncremental)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({2, 3}, DataType::Float32);
+        Tensor c = g->addTensor({1, 3}, DataType::Float32);
+        Tensor d = g->addTensor({2, 3}, DataType::Float32);
+        auto relu = g->addOp<ReluObj>(a, nullptr);
+        auto t = g->addOp<TransposeObj>(relu->getOutput(), nullptr, Shape{1, 0});
+        auto add = g->addOp<AddObj>(c, d, nullptr);
+        auto branch = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        EXPECT_EQ(g->shape_infer(), (size_t)4);
+        EXPECT_EQ(g->shape_infer(), (size_t)0);
+
+        // only the ops reading a are inferred again
+        a->setShape({5, 3});
+        EXPECT_EQ(g->shape_infer(), (size_t)2);
+        EXPECT_EQ(t->getOutput()->getDims(), (Shape{3, 5}));
+
+        // the add output keeps its shape, so its reader is not inferred
+        c->setShape({2, 3});
+        EXPECT_EQ(g->shape_infer(), (size_t)1);
+        EXPECT_EQ(branch->getOutput()->getDims(), (Shape{2, 3}));
+
+        // a new op infers the whole graph
+        g->addOp<ReluObj>(branch->getOutput(), nullptr);
+        EXPECT_EQ(g->shape_infer(), (size_t)5);
+    }
+
+    TEST(Graph, DataMallocCachedPlans)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        auto t = g->addOp<TransposeObj>(i, nullptr, Shape{1, 0});
+        auto relu = g->addOp<ReluObj>(t->getOutput(), nullptr);
+        auto o = relu->getOutput();
+        auto runWithBatch = [&](int batch)
+        {
+            i->setShape({batch, 3});
+            g->shape_infer();
+            g->dataMalloc();
+            i->setData(IncrementalGenerator());
+            runtime->run(g);
+            EXPECT_EQ(o->getDims(), (Shape{3, batch}));
+            vector<float> ans;
+            for (int r = 0; r < 3; ++r)
+                for (int c = 0; c < batch; ++c)
+                    ans.emplace_back(c * 3 + r);
+            EXPECT_TRUE(o->equalData(ans));
+            return o->getRawDataPtr<void *>();
+        };
+        runWithBatch(2);
+        // the larger batch grows the arena once
+        auto large = runWithBatch(64);
+        runWithBatch(2);
+        // back to a known batch: the cached plan is rebound to the same arena
+        EXPECT_EQ(runWithBatch(64), large);
+        EXPECT_EQ(runWithBatch(64), large);
+    }
+
+    TEST(Graph, DataMallocShapeBuckets)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        Tensor j = g->addTensor({2, 3}, DataType::Float32);
+        i->setSymbolicDim(0, "batch");
+        j->setSymbolicDim(0, "batch");
+        g->setShapeBuckets("batch", {4, 16});
+        auto r1 = g->addOp<ReluObj>(i, nullptr);
+        auto r2 = g->addOp<ReluObj>(j, nullptr);
+        auto concat = g->addOp<ConcatObj>(
+            TensorVec{r1->getOutput(), r2->getOutput()}, nullptr, 0);
+        auto t = g->addOp<TransposeObj>(concat->getOutput(), nullptr,
+                                        Shape{1, 0});
+        auto o = t->getOutput();
+        auto runWithBatch = [&](int batch)
+        {
+            i->setShape({batch, 3});
+            j->setShape({batch, 3});
+            g->shape_infer();
+            g->dataMalloc();
+            i->setData(IncrementalGenerator());
+            j->setData(IncrementalGenerator());
+            runtime->run(g);
+            EXPECT_EQ(o->getDims(), (Shape{3, 2 * batch}));
+            // the slices follow the actual shapes inside the padded block
+            EXPECT_EQ(r2->getOutput()->getRawDataPtr<float *>(),
+                      concat->getOutput()->getRawDataPtr<float *>() +
+                          batch * 3);
+            vector<float> ans;
+            for (int c = 0; c < 3; ++c)
+                for (int r = 0; r < 2 * batch; ++r)
+                    ans.emplace_back((r % batch) * 3 + c);
+            EXPECT_TRUE(o->equalData(ans));
+            return &g->getMemoryReport();
+        };
+        // every batch up to 4 shares the plan compiled for 4
+        auto small = runWithBatch(2);
+        EXPECT_EQ(runWithBatch(3), small);
+        EXPECT_EQ(runWithBatch(4), small);
+        EXPECT_EQ(i->getDims(), (Shape{4, 3}));
+        auto large = runWithBatch(5);
+        EXPECT_NE(large, small);
+        EXPECT_EQ(runWithBatch(16), large);
+        EXPECT_EQ(runWithBatch(1), small);
+
+        i->setShape({17, 3});
+        j->setShape({17, 3});
+        g->shape_infer();
+        EXPECT_THROW(g->dataMalloc(), Exception);
+    }
+
+    TEST(Graph, DataMallocShapeBucketsBroadcast)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({8, 4}, DataType::Float32);
+        Tensor b = g->addTensor({8, 4}, DataType::Float32);
+        x->setSymbolicDim(0, "n");
+        g->setShapeBuckets("n", {8});
+        auto relu = g->addOp<ReluObj>(x, nullptr);
+        auto add = g->addOp<AddObj>(relu->getOutput(), b, nullptr);
+        x->setShape({1, 4});
+        g->shape_infer();
+        g->dataMalloc();
+        // at n = 1 the relu output is broadcast, the add can not overwrite it
+        EXPECT_NE(add->getOutput()->getRawDataPtr<void *>(),
+                  relu->getOutput()->getRawDataPtr<void *>());
+        // planning at the padded shape leaves the actual ones in place
+        EXPECT_EQ(relu->getOutput()->getDims(), (Shape{1, 4}));
+        EXPECT_EQ(g->shape_infer(), (size_t)0);
+        x->setData(IncrementalGenerator());
+        b->setData(IncrementalGenerator());
+        runtime->run(g);
+        vector<float> ans;
+        for (int r = 0; r < 8; ++r)
+            for (int c = 0; c < 4; ++c)
+                ans.emplace_back(r * 4 + 2 * c);
+        EXPECT_TRUE(add->getOutput()->equalData(ans));
+    }
+
+    TEST(Graph, DataMallocShapeBucketsMatmul)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto runWithBatch = [&](int batch, bool buckets)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor x = g->addTensor({1, 3}, DataType::Float32);
+            Tensor w = g->addTensor({3, 4}, DataType::Float32);
+            x->setSymbolicDim(0, "batch");
+            if (buckets)
+                g->setShapeBuckets("batch", {2, 4, 8});
+            auto matmul = g->addOp<MatmulObj>(x, w, nullptr);
+            auto relu = g->addOp<ReluObj>(matmul->getOutput(), nullptr);
+            x->setShape({batch, 3});
+            g->shape_infer();
+            g->dataMalloc();
+            x->setData(IncrementalGenerator());
+            w->setData(IncrementalGenerator());
+            runtime->run(g);
+            // the matmul runs at the actual batch, not the padded one
+            EXPECT_EQ(matmul->getM(), batch);
+            auto p = relu->getOutput()->getRawDataPtr<float *>();
+            return vector<float>(p, p + relu->getOutput()->size());
+        };
+        for (int batch : {1, 3, 5})
+            EXPECT_EQ(runWithBatch(batch, true), runWithBatch(batch, false));
+    }
+
+    TEST(Graph, ShapeInferSymbols)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({2, 3}, DataType::Float32);
+        Tensor b = g->addTensor({3, 4}, DataType::Float32);
+        Tensor c = g->addTensor({1, 4}, DataType::Float32);
+        Tensor d = g->addTensor({2, 4}, DataType::Float32);
+        a->setSymbolicDim(0, "m");
+        d->setSymbolicDim(0, "k");
+        auto matmul = g->addOp<MatmulObj>(a, b, nullptr);
+        auto add = g->addOp<AddObj>(matmul->getOutput(), c, nullptr);
+        auto concat = g->addOp<ConcatObj>(TensorVec{add->getOutput(), d},
+                                          nullptr, 0);
+        auto t = g->addOp<TransposeObj>(concat->getOutput(), nullptr,
+                                        Shape{1, 0});
+        auto mixed = g->addOp<AddObj>(add->getOutput(), d, nullptr);
+        g->shape_infer();
+        EXPECT_EQ(matmul->getOutput()->getSymbolicDims(),
+                  (vector<string>{"m", ""}));
+        // the fixed 1 of c is stretched to m
+        EXPECT_EQ(add->getOutput()->getSymbolicDims(),
+                  (vector<string>{"m", ""}));
+        EXPECT_EQ(t->getOutput()->getSymbolicDims(),
+                  (vector<string>{"", "m+k"}));
+        // m and k are both 2 now, but they stay apart
+        EXPECT_EQ(mixed->getOutput()->getSymbolicDims(),
+                  (vector<string>{"max(m,k)", ""}));
+
+        // a new symbol is inferred incrementally; the fixed 4 of c pins n,
+        // so the propagation stops at the add
+        b->setSymbolicDim(1, "n");
+        EXPECT_EQ(g->shape_infer(), (size_t)2);
+        EXPECT_EQ(matmul->getOutput()->getSymbolicDims(),
+                  (vector<string>{"m", "n"}));
+        EXPECT_EQ(add->getOutput()->getSymbolicDims(),
+                  (vector<string>{"m", ""}));
+    }
+
+    TEST(Graph, Workspace)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3, 4}, DataType::Float32);
+        Tensor b = g->addTensor({4, 1, 1, 3}, DataType::Float32);
+        auto t = g->addOp<TransposeObj>(i, nullptr, Shape{0, 2, 1});
+        auto add = g->addOp<AddObj>(t->getOutput(), b, nullptr);
+        g->dataMalloc();
+        // the largest request: element-wise needs 3 words per output dim
+        EXPECT_EQ(g->getWorkspaceSize(), 3 * 4 * sizeof(size_t));
+        EXPECT_EQ((uintptr_t)g->getWorkspace() % g->getAlignment(),
+                  (uintptr_t)0);
+        i->setData(IncrementalGenerator());
+        b->setData(OneGenerator());
+        runtime->run(g);
+        vector<float> ans;
+        for (int x = 0; x < 4; ++x)
+            for (int n = 0; n < 2; ++n)
+                for (int c = 0; c < 4; ++c)
+                    for (int h = 0; h < 3; ++h)
+                        ans.emplace_back(n * 12 + h * 4 + c + 1);
+        EXPECT_TRUE(add->getOutput()->equalData(ans));
+        EXPECT_THROW(runtime->getWorkspace(g->getWorkspaceSize() + 1),
+                     Exception);
+    }
+}
@@ -0,0 +1,154 @@
+#include "core/execution_context.h"
+#include "core/graph.h"
+#include "core/graph_serializer.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace infini
+{
+    TEST(GraphSerializer, SaveAndLoad)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        string path = testing::TempDir() + "graph_serializer_test.bin";
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        Tensor c = g->addTensor({2, 2}, DataType::Float32);
+        Tensor w = g->addTensor({3, 4}, DataType::Float32);
+        Tensor bias = g->addTensor({4}, DataType::Float32);
+        w->setWeight();
+        bias->setWeight();
+        auto matmul = g->addOp<MatmulObj>(i, w, nullptr, false, false, bias,
+                                          ActType::Clip, 0.f, 20.f);
+        auto concat = g->addOp<ConcatObj>(TensorVec{matmul->getOutput(), c},
+                                          nullptr, 1);
+        auto t = g->addOp<TransposeObj>(concat->getOutput(), nullptr,
+                                        Shape{1, 0});
+        g->addOp<ClipObj>(t->getOutput(), nullptr, -1.f, std::nullopt);
+        g->bindWeights();
+        w->setData(IncrementalGenerator());
+        bias->setData(IncrementalGenerator());
+        GraphSerializer::save(g, path);
+
+        auto runGraph = [&](const Graph &graph)
+        {
+            graph->dataMalloc();
+            graph->getInputs()[0]->setData(IncrementalGenerator());
+            graph->getInputs()[1]->setData(IncrementalGenerator());
+            runtime->run(graph);
+            auto output = graph->getOutputs()[0];
+            auto p = output->getRawDataPtr<float *>();
+            return vector<float>(p, p + output->size());
+        };
+        Graph loaded = GraphSerializer::load(runtime, path);
+        EXPECT_EQ(loaded->getOperators().size(), (size_t)4);
+        // the inferred boundary is inferred again, weights are not inputs
+        EXPECT_FALSE(loaded->hasDeclaredInputs());
+        EXPECT_EQ(loaded->getInputs().size(), g->getInputs().size());
+        EXPECT_EQ(runGraph(loaded), runGraph(g));
+
+        // the weights are read from the mapped file, aligned as in the arena
+        auto loadedW = loaded->getOperators()[0]->getInputs(1);
+        EXPECT_TRUE(loadedW->isWeight());
+        EXPECT_EQ((size_t)loadedW->getRawDataPtr<void *>() % g->getAlignment(),
+                  (size_t)0);
+        EXPECT_TRUE(loadedW->equalData(w));
+        std::remove(path.c_str());
+    }
+
+    TEST(GraphSerializer, OptimizeLoaded)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        string path = testing::TempDir() + "graph_serializer_optimize.bin";
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({3, 4}, DataType::Float32);
+        Tensor w = g->addTensor({4, 3}, DataType::Float32);
+        w->setWeight();
+        auto t = g->addOp<TransposeObj>(w, nullptr, Shape{1, 0});
+        g->addOp<AddObj>(i, t->getOutput(), nullptr);
+        g->setInputs({i, w});
+        g->bindWeights();
+        w->setData(IncrementalGenerator());
+        GraphSerializer::save(g, path);
+
+        auto runGraph = [&](const Graph &graph)
+        {
+            graph->dataMalloc();
+            graph->getInputs()[0]->setData(IncrementalGenerator());
+            runtime->run(graph);
+            auto output = graph->getOutputs()[0];
+            auto p = output->getRawDataPtr<float *>();
+            return vector<float>(p, p + output->size());
+        };
+        // w is a declared input; folding the transpose drops it from the
+        // boundary as well
+        Graph loaded = GraphSerializer::load(runtime, path);
+        EXPECT_TRUE(loaded->hasDeclaredInputs());
+        EXPECT_FALSE(loaded->hasDeclaredOutputs());
+        loaded->optimize();
+        EXPECT_EQ(loaded->getOperators().size(), (size_t)1);
+        EXPECT_EQ(loaded->getInputs().size(), (size_t)1);
+        EXPECT_TRUE(loaded->checkValid());
+        EXPECT_NO_THROW(GraphSerializer::save(loaded, path));
+        EXPECT_NO_THROW(make_ref<CompiledPlanObj>(loaded));
+        EXPECT_EQ(runGraph(loaded), runGraph(g));
+        std::remove(path.c_str());
+    }
+
+    TEST(GraphSerializer, LoadCorrupt)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        string path = testing::TempDir() + "graph_serializer_corrupt.bin";
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({3, 4}, DataType::Float32);
+        Tensor bias = g->addTensor({4}, DataType::Float32);
+        w->setWeight();
+        bias->setWeight();
+        g->addOp<MatmulObj>(i, w, nullptr, false, false, bias);
+        g->bindWeights();
+        w->setData(IncrementalGenerator());
+        bias->setData(IncrementalGenerator());
+        GraphSerializer::save(g, path);
+        std::ifstream in(path, std::ios::binary);
+        string bytes{std::istreambuf_iterator<char>(in), {}};
+        in.close();
+
+        auto loadBytes = [&](const string &content)
+        {
+            std::ofstream(path, std::ios::binary) << content;
+            return GraphSerializer::load(runtime, path);
+        };
+        EXPECT_EQ(loadBytes(bytes)->getOperators().size(), (size_t)1);
+        // the tensor count follows the 32 byte header, then the first dtype
+        auto patch = [&](size_t offset, auto value)
+        {
+            string content = bytes;
+            std::memcpy(content.data() + offset, &value, sizeof(value));
+            return content;
+        };
+        EXPECT_THROW(loadBytes(bytes.substr(0, 60)), Exception);
+        EXPECT_THROW(loadBytes(bytes.substr(0, bytes.size() - 1)), Exception);
+        EXPECT_THROW(loadBytes(patch(32, (uint64_t)1 << 60)), Exception);
+        EXPECT_THROW(loadBytes(patch(40, (int32_t)100)), Exception);
+        EXPECT_THROW(loadBytes(patch(40, (int32_t)DataType::String.getIndex())),
+                     Exception);
+        // w takes 48 bytes, so the bias starts at an odd multiple of the
+        // alignment and breaks a header claiming twice that
+        EXPECT_THROW(loadBytes(patch(12, (uint32_t)(2 * g->getAlignment()))),
+                     Exception);
+        // weight section that ends past the file
+        EXPECT_THROW(loadBytes(patch(24, (uint64_t)-1)), Exception);
+        std::remove(path.c_str());
+    }
+
+} // namespace infini
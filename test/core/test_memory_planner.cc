@@ -0,0 +1,117 @@
+#include "core/graph.h"
+#include "core/memory_planner.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(MemoryPlanner, GreedyBySizeReachesLowerBound)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        // a dies at step 0, c can not fit into its hole while b is live
+        vector<BufferLifetime> lifetimes = {
+            {16, 0, 0}, {16, 0, 2}, {32, 1, 2}};
+        Allocator online(runtime, 8), offline(runtime, 8);
+        auto onlinePlan = MemoryPlanner::plan(
+            lifetimes, MemoryPlanStrategy::Online, online);
+        auto offlinePlan = MemoryPlanner::plan(
+            lifetimes, MemoryPlanStrategy::GreedyBySize, offline);
+        EXPECT_EQ(onlinePlan.lowerBound, (size_t)48);
+        EXPECT_EQ(onlinePlan.peak, (size_t)64);
+        EXPECT_EQ(offlinePlan.peak, (size_t)48);
+        EXPECT_EQ(offline.getPeak(), offlinePlan.peak);
+    }
+
+    TEST(MemoryPlanner, GreedyBySizeNoOverlap)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        vector<BufferLifetime> lifetimes;
+        for (size_t i = 0; i < 64; ++i)
+            lifetimes.push_back({8 * (i % 7 + 1), i % 13, i % 13 + i % 5});
+        Allocator allocator(runtime);
+        auto plan = MemoryPlanner::plan(
+            lifetimes, MemoryPlanStrategy::GreedyBySize, allocator);
+        EXPECT_GE(plan.peak, plan.lowerBound);
+        for (size_t i = 0; i < lifetimes.size(); ++i)
+            for (size_t j = i + 1; j < lifetimes.size(); ++j)
+            {
+                auto &a = lifetimes[i], &b = lifetimes[j];
+                if (a.end < b.begin || b.end < a.begin)
+                    continue;
+                EXPECT_TRUE(plan.offsets[i] + a.size <= plan.offsets[j] ||
+                            plan.offsets[j] + b.size <= plan.offsets[i]);
+            }
+    }
+
+    TEST(MemoryPlanner, GraphGreedyBySize)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto i = g->addTensor({2, 3, 4}, DataType::Float32);
+        auto r1 = g->addOp<ReluObj>(i, nullptr);
+        auto r2 = g->addOp<ReluObj>(r1->getOutput(), nullptr);
+        auto add = g->addOp<AddObj>(r1->getOutput(), r2->getOutput(), nullptr);
+        g->dataMalloc(MemoryPlanStrategy::GreedyBySize);
+        i->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(add->getOutput()->equalData(
+            vector<float>{0,  2,  4,  6,  8,  10, 12, 14, 16, 18, 20, 22,
+                          24, 26, 28, 30, 32, 34, 36, 38, 40, 42, 44, 46}));
+    }
+
+    TEST(MemoryReport, Timeline)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        vector<BufferLifetime> lifetimes = {
+            {16, 0, 0}, {16, 0, 2}, {32, 1, 2}};
+        Allocator allocator(runtime, 8);
+        auto plan = MemoryPlanner::plan(
+            lifetimes, MemoryPlanStrategy::Online, allocator);
+        MemoryReport report;
+        for (size_t step = 0; step < 3; ++step)
+            report.steps.push_back({step, 0, "", 0, 0, 0.});
+        report.computeTimeline(lifetimes, plan.offsets, 3);
+        // c goes above the hole left by a
+        EXPECT_EQ(report.steps[0].liveBytes, (size_t)32);
+        EXPECT_EQ(report.steps[0].extentBytes, (size_t)32);
+        EXPECT_EQ(report.steps[1].liveBytes, (size_t)48);
+        EXPECT_EQ(report.steps[1].extentBytes, (size_t)64);
+        EXPECT_DOUBLE_EQ(report.steps[1].fragmentation, 0.25);
+        EXPECT_EQ(report.peakStep, (size_t)1);
+    }
+
+    TEST(MemoryReport, Graph)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto i = g->addTensor({2, 3, 4}, DataType::Float32);
+        auto r1 = g->addOp<ReluObj>(i, nullptr);
+        g->addOp<ReluObj>(r1->getOutput(), nullptr);
+        g->dataMalloc();
+        const auto &report = g->getMemoryReport();
+        EXPECT_EQ(report.peak, (size_t)256);
+        // three 128-byte blocks without reuse
+        EXPECT_EQ(report.naiveBytes, (size_t)384);
+        ASSERT_EQ(report.tensors.size(), (size_t)3);
+        ASSERT_EQ(report.steps.size(), (size_t)2);
+        // the input is pinned, the output of r2 reuses the block of r1
+        const auto &in = report.tensors[0], &mid = report.tensors[1],
+                   &out = report.tensors[2];
+        EXPECT_EQ(in.fuid, i->getFuid());
+        EXPECT_EQ(mid.firstUse, (size_t)0);
+        EXPECT_EQ(mid.lastUse, (size_t)1);
+        EXPECT_FALSE(mid.inPlace);
+        EXPECT_TRUE(out.inPlace);
+        EXPECT_EQ(out.offset, mid.offset);
+        EXPECT_EQ(report.getPeakStep().opGuid, r1->getGuid());
+        EXPECT_EQ(report.getPeakStep().extentBytes, report.peak);
+        EXPECT_EQ(report.toJson().rfind("{\"strategy\":\"online\"", 0),
+                  (size_t)0);
+        auto csv = report.tensorsToCsv();
+        EXPECT_EQ(std::count(csv.begin(), csv.end(), '\n'), 4);
+    }
+
+} // namespace infini
@@ -0,0 +1,70 @@
+#include "core/execution_context.h"
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// every heap allocation of this test binary, to check that a warm run makes
+// none
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace infini
+{
+    TEST(Runtime, RunWithoutAllocation)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({3, 4}, DataType::Float32);
+        Tensor bias = g->addTensor({4}, DataType::Float32);
+        w->setWeight();
+        bias->setWeight();
+        auto matmul = g->addOp<MatmulObj>(i, w, nullptr, false, false, bias,
+                                          ActType::Relu);
+        auto relu = g->addOp<ReluObj>(matmul->getOutput(), nullptr);
+        auto add = g->addOp<AddObj>(relu->getOutput(), bias, nullptr);
+        auto concat = g->addOp<ConcatObj>(
+            TensorVec{add->getOutput(), matmul->getOutput()}, nullptr, 1);
+        g->addOp<TransposeObj>(concat->getOutput(), nullptr, Shape{1, 0});
+        g->bindWeights();
+        w->setData(IncrementalGenerator());
+        bias->setData(IncrementalGenerator());
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+
+        // the first run may set up the runtime, e.g. its thread pool
+        runtime->run(g);
+        size_t before = allocations;
+        for (int round = 0; round < 10; ++round)
+            runtime->run(g);
+        EXPECT_EQ(allocations - before, (size_t)0);
+
+        auto context =
+            make_ref<ExecutionContextObj>(make_ref<CompiledPlanObj>(g));
+        runtime->run(context);
+        before = allocations;
+        for (int round = 0; round < 10; ++round)
+            runtime->run(context);
+        EXPECT_EQ(allocations - before, (size_t)0);
+    }
+
+} // namespace infini
@@ -0,0 +1,120 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "core/weight_region.h"
+#include "operators/element_wise.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(WeightRegion, KeptAcrossReplanning)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto i = g->addTensor({1, 4}, DataType::Float32);
+        auto w = g->addTensor({4}, DataType::Float32);
+        w->setWeight();
+        auto add = g->addOp<AddObj>(i, w, nullptr);
+        g->dataMalloc();
+        w->setData(IncrementalGenerator());
+        auto weightPtr = w->getRawDataPtr<void *>();
+
+        // a new batch size re-plans the activations only
+        i->setShape({3, 4});
+        g->shape_infer();
+        g->dataMalloc();
+        EXPECT_EQ(w->getRawDataPtr<void *>(), weightPtr);
+        i->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(add->getOutput()->equalData(
+            vector<float>{1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4}));
+        EXPECT_EQ(g->getWeightRegion()->getSize(), (size_t)64);
+    }
+
+    TEST(WeightRegion, SharedBetweenGraphs)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g1 = make_ref<GraphObj>(runtime);
+        auto w = g1->addTensor({4}, DataType::Float32);
+        w->setWeight();
+        auto add1 = g1->addOp<MulObj>(g1->addTensor({2, 4}), w, nullptr);
+        g1->dataMalloc();
+        w->setData(IncrementalGenerator());
+
+        // a second executor of the same model binds the clone of the weight
+        // to the same block, without loading it again
+        Graph g2 = make_ref<GraphObj>(runtime);
+        auto w2 = g2->addTensor(w->clone());
+        auto i2 = g2->addTensor({2, 4});
+        auto add2 = g2->addOp<MulObj>(i2, w2, nullptr);
+        g2->setWeightRegion(g1->getWeightRegion());
+        g2->dataMalloc();
+        EXPECT_EQ(w2->getRawDataPtr<void *>(), w->getRawDataPtr<void *>());
+        EXPECT_NE(i2->getRawDataPtr<void *>(),
+                  add1->getInputs(0)->getRawDataPtr<void *>());
+        i2->setData(OneGenerator());
+        runtime->run(g2);
+        EXPECT_TRUE(add2->getOutput()->equalData(
+            vector<float>{0, 1, 2, 3, 0, 1, 2, 3}));
+        EXPECT_TRUE(g1->sharesWeightRegion());
+        EXPECT_TRUE(g2->sharesWeightRegion());
+
+        // weights added later go to a new chunk, the bound data stays
+        auto extra = g2->addTensor({4}, DataType::Float32);
+        extra->setWeight();
+        g2->addOp<AddObj>(add2->getOutput(), extra, nullptr);
+        g2->dataMalloc();
+        EXPECT_EQ(w2->getRawDataPtr<void *>(), w->getRawDataPtr<void *>());
+        EXPECT_TRUE(w->equalData(vector<float>{0, 1, 2, 3}));
+        EXPECT_NE(extra->getRawDataPtr<void *>(), nullptr);
+    }
+
+    TEST(WeightRegion, Release)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto region = make_ref<WeightRegionObj>(runtime);
+        auto weight = [&]()
+        {
+            auto w = make_ref<TensorObj>(Shape{4}, DataType::Float32, runtime);
+            w->setWeight();
+            return w;
+        };
+        auto a = weight(), b = weight(), c = weight();
+        region->bind({a, b});
+        auto aPtr = a->getRawDataPtr<void *>();
+        EXPECT_EQ(region->getSize(), (size_t)128);
+
+        // the hole of a takes c in the bound chunk
+        region->release(a);
+        EXPECT_FALSE(region->contains(a));
+        region->bind({c});
+        EXPECT_EQ(c->getRawDataPtr<void *>(), aPtr);
+        EXPECT_EQ(region->getSize(), (size_t)128);
+
+        // the chunk is freed with its last weight
+        region->release(b);
+        region->release(c);
+        EXPECT_EQ(region->getSize(), (size_t)0);
+    }
+
+    TEST(WeightRegion, PinnedRelease)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto region = make_ref<WeightRegionObj>(runtime);
+        auto a = make_ref<TensorObj>(Shape{4}, DataType::Float32, runtime);
+        a->setWeight();
+        region->bind({a});
+        region->pin({a});
+        region->pin({a});
+
+        // the block stays until the last snapshot reading it is gone
+        region->release(a);
+        EXPECT_EQ(region->getSize(), (size_t)64);
+        region->unpin({a});
+        EXPECT_EQ(region->getSize(), (size_t)64);
+        region->unpin({a});
+        EXPECT_FALSE(region->contains(a));
+        EXPECT_EQ(region->getSize(), (size_t)0);
+    }
+
+} // namespace infini
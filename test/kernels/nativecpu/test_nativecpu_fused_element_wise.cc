@@ -0,0 +1,31 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/fused_element_wise.h"
+
+#include "test.h"
+
+namespace infini {
+
+TEST(FusedElementWise, NativeCpu) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor({2, 3}, DataType::Float32);
+    auto b = g->addTensor({3}, DataType::Float32);
+    // clip(relu(a - b) * a, max = 4)
+    vector<FusedElementWiseStep> steps = {
+        {OpType::Sub, 0, 1, {}, {}},
+        {OpType::Relu, 2, -1, {}, {}},
+        {OpType::Mul, 3, 0, {}, {}},
+        {OpType::Clip, 4, -1, {}, 4.0f},
+    };
+    auto op = g->addOp<FusedElementWiseObj>(TensorVec{a, b}, nullptr, steps);
+    EXPECT_EQ(op->getOutput()->getDims(), (Shape{2, 3}));
+    g->dataMalloc();
+    a->setData(IncrementalGenerator());
+    b->setData(OneGenerator());
+    runtime->run(g);
+    EXPECT_TRUE(
+        op->getOutput()->equalData(vector<float>{0, 0, 2, 4, 4, 4}));
+}
+
+} // namespace infini
@@ -0,0 +1,64 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/matmul.h"
+
+#include "test.h"
+
+namespace infini {
+
+using ExpectOutput = vector<float>;
+void testMatmulNativeCpu(const Shape &shapeA, const Shape &shapeB, bool transA,
+                         bool transB, const ExpectOutput &ansVec,
+                         const Shape &shapeBias = {},
+                         ActType act = ActType::None,
+                         std::optional<float> clipMax = std::nullopt) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor(shapeA, DataType::Float32);
+    auto b = g->addTensor(shapeB, DataType::Float32);
+    auto bias =
+        shapeBias.empty() ? nullptr : g->addTensor(shapeBias, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(a, b, nullptr, transA, transB, bias, act,
+                                  std::nullopt, clipMax);
+    g->dataMalloc();
+    a->setData(IncrementalGenerator());
+    b->setData(IncrementalGenerator());
+    if (bias)
+        bias->setData(OneGenerator());
+
+    runtime->run(g);
+    EXPECT_TRUE(op->getOutput()->equalData(ansVec));
+}
+
+TEST(Matmul, NativeCpu) {
+    testMatmulNativeCpu({2, 3}, {3, 2}, false, false,
+                        ExpectOutput{10, 13, 28, 40});
+    testMatmulNativeCpu({2, 3}, {2, 3}, false, true,
+                        ExpectOutput{5, 14, 14, 50});
+    // the batch of B is broadcast
+    testMatmulNativeCpu({2, 2, 3}, {3, 2}, false, false,
+                        ExpectOutput{10, 13, 28, 40, 46, 67, 64, 94});
+    // epilogue: bias broadcast over the rows, then clip
+    testMatmulNativeCpu({2, 3}, {2, 3}, false, true,
+                        ExpectOutput{6, 15, 15, 30}, {2}, ActType::Clip, 30.f);
+}
+
+TEST(Matmul, NativeCpuTiled) {
+    // larger than one tile in every direction, C[i][j] = 150 * sum(p) + 140 j
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto a = g->addTensor({140, 70}, DataType::Float32);
+    auto b = g->addTensor({140, 150}, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(a, b, nullptr, true, false);
+    g->dataMalloc();
+    a->setData(OneGenerator());
+    b->setData(IncrementalGenerator());
+    runtime->run(g);
+    ExpectOutput ans;
+    for (int i = 0; i < 70; ++i)
+        for (int j = 0; j < 150; ++j)
+            ans.emplace_back(150.f * 9730 + 140.f * j);
+    EXPECT_TRUE(op->getOutput()->equalData(ans));
+}
+
+} // namespace infini
@@ -52,6 +52,15 @@ namespace infini
             auto C = matmul->getOutputs()[0];
             EXPECT_EQ(C->getDims(), (Shape{2, 3, 4, 2}));
         }
+        {
+            // batch dims align to the right
+            Graph g = make_ref<GraphObj>(runtime);
+            auto A = g->addTensor(Shape{5, 2, 3, 4});
+            auto B = g->addTensor(Shape{2, 4, 6});
+            auto matmul = g->addOp<MatmulObj>(A, B, nullptr);
+            auto C = matmul->getOutputs()[0];
+            EXPECT_EQ(C->getDims(), (Shape{5, 2, 3, 6}));
+        }
     }
 
 }; // namespace infini
\ No newline at end of file